@@ -0,0 +1,153 @@
+#include "config.h"
+#include "lib.h"
+#include "pit.h"
+#include "keyboard.h"
+#include "console.h"
+
+// Compile time defaults, the command line only changes what it names
+kernel_config_t kernel_config = {
+    PIT_DEFAULT_HZ,     // pit_hz
+    1,                  // tickless
+    MAX_TERMINALS,      // terminals
+    0,                  // max_processes
+    KEYBOARD_LIMIT,     // line_limit
+    1,                  // trace
+    0,                  // profile
+    CONSOLE_SCROLLBACK_DEFAULT, // scrollback
+    ""                  // tests
+};
+
+static int32_t config_set(const int8_t* key, uint32_t key_length, const int8_t* value, uint32_t value_length);
+static int32_t config_key(const int8_t* key, uint32_t key_length, const int8_t* name);
+static int32_t config_number(const int8_t* value, uint32_t length, uint32_t min, uint32_t max, uint32_t* number);
+
+/* config_parse
+ * DESCRIPTION: Splits the command line at spaces and sets the knob each
+ *              key=value word names. Words without '=', like the kernel
+ *              path GRUB passes first, are skipped. Bad words are reported
+ *              and leave their knob at its default. Runs before paging,
+ *              while the command line is still reachable
+ * INPUTS: cmdline - NUL terminated command line from the boot loader
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Changes kernel_config
+ */
+void config_parse(const int8_t* cmdline) {
+    const int8_t* word;
+    uint32_t i, length, key_length;
+    if (cmdline == NULL) { return; }
+
+    while (*cmdline != '\0') {
+        while (*cmdline == ' ') { cmdline++; }
+        word = cmdline;
+        while (*cmdline != ' ' && *cmdline != '\0') { cmdline++; }
+        length = cmdline - word;
+
+        for (key_length = 0; key_length < length && word[key_length] != '='; key_length++);
+        if (key_length == length) { continue; }
+        if (config_set(word, key_length, word + key_length + 1, length - key_length - 1) == FAILURE) {
+            printf("cmdline: ignoring ");
+            for (i = 0; i < length; i++) { putc(word[i]); }
+            printf("\n");
+        }
+    }
+}
+
+/* config_selects
+ * DESCRIPTION: Looks for a test in the comma separated tests= list
+ * INPUTS: name - test name
+ * OUTPUTS: 1 if the list names it or is "all", 0 otherwise
+ * SIDE EFFECTS: NONE
+ */
+int32_t config_selects(const int8_t* name) {
+    const int8_t* list = kernel_config.tests;
+    const int8_t* entry;
+    uint32_t length = strlen(name);
+
+    if (config_key(list, strlen(list), CONFIG_ALL)) { return 1; }
+    while (*list != '\0') {
+        entry = list;
+        while (*list != CONFIG_LIST_SEP && *list != '\0') { list++; }
+        if (list - entry == length && strncmp(entry, name, length) == 0) { return 1; }
+        if (*list == CONFIG_LIST_SEP) { list++; }
+    }
+    return 0;
+}
+
+/* config_set
+ * DESCRIPTION: Sets the knob a key names from its value
+ * INPUTS: key, key_length - key, not NUL terminated
+ *         value, value_length - value, not NUL terminated
+ * OUTPUTS: SUCCESS, FAILURE for an unknown key or a bad value
+ * SIDE EFFECTS: Changes kernel_config
+ */
+static int32_t config_set(const int8_t* key, uint32_t key_length, const int8_t* value, uint32_t value_length) {
+    uint32_t number;
+
+    if (config_key(key, key_length, "quantum")) {
+        // the slice in ms has to come out at a rate the PIT takes
+        if (config_number(value, value_length, MS_PER_SECOND / PIT_MAX_HZ, MS_PER_SECOND / PIT_MIN_HZ, &number) == FAILURE) { return FAILURE; }
+        kernel_config.pit_hz = MS_PER_SECOND / number;
+    } else if (config_key(key, key_length, "tickless")) {
+        if (config_number(value, value_length, 0, 1, &number) == FAILURE) { return FAILURE; }
+        kernel_config.tickless = number;
+    } else if (config_key(key, key_length, "terminals")) {
+        if (config_number(value, value_length, 1, MAX_TERMINALS, &number) == FAILURE) { return FAILURE; }
+        kernel_config.terminals = number;
+    } else if (config_key(key, key_length, "procs")) {
+        // every terminal needs a shell
+        if (config_number(value, value_length, MAX_TERMINALS, PID_LIMIT, &number) == FAILURE) { return FAILURE; }
+        kernel_config.max_processes = number;
+    } else if (config_key(key, key_length, "line")) {
+        if (config_number(value, value_length, 1, KEYBOARD_LIMIT, &number) == FAILURE) { return FAILURE; }
+        kernel_config.line_limit = number;
+    } else if (config_key(key, key_length, "trace")) {
+        if (config_number(value, value_length, 0, 1, &number) == FAILURE) { return FAILURE; }
+        kernel_config.trace = number;
+    } else if (config_key(key, key_length, "profile")) {
+        if (config_number(value, value_length, 0, 1, &number) == FAILURE) { return FAILURE; }
+        kernel_config.profile = number;
+    } else if (config_key(key, key_length, "scrollback")) {
+        if (config_number(value, value_length, 0, CONSOLE_SCROLLBACK_MAX, &number) == FAILURE) { return FAILURE; }
+        kernel_config.scrollback = number;
+    } else if (config_key(key, key_length, "tests")) {
+        if (value_length >= CONFIG_TESTS_MAX) { return FAILURE; }
+        strncpy(kernel_config.tests, value, value_length);
+        kernel_config.tests[value_length] = '\0';
+    } else {
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/* config_key
+ * DESCRIPTION: Compares a key from the command line with a knob's name
+ * INPUTS: key, key_length - key, not NUL terminated
+ *         name - name of the knob
+ * OUTPUTS: 1 if they are the same, 0 otherwise
+ * SIDE EFFECTS: NONE
+ */
+static int32_t config_key(const int8_t* key, uint32_t key_length, const int8_t* name) {
+    return strlen(name) == key_length && strncmp(key, name, key_length) == 0;
+}
+
+/* config_number
+ * DESCRIPTION: Reads a decimal value and checks its range
+ * INPUTS: value, length - digits, not NUL terminated
+ *         min, max - range the value has to be in
+ *         number - where the value goes
+ * OUTPUTS: SUCCESS, FAILURE if it isn't a number in range
+ * SIDE EFFECTS: NONE
+ */
+static int32_t config_number(const int8_t* value, uint32_t length, uint32_t min, uint32_t max, uint32_t* number) {
+    uint32_t i, result = 0;
+    if (length == 0) { return FAILURE; }
+
+    for (i = 0; i < length; i++) {
+        if (value[i] < '0' || value[i] > '9') { return FAILURE; }
+        result = result * 10 + (value[i] - '0');
+        if (result > max) { return FAILURE; }
+    }
+    if (result < min) { return FAILURE; }
+    *number = result;
+    return SUCCESS;
+}
@@ -0,0 +1,42 @@
+#ifndef _CONFIG_H
+#define _CONFIG_H
+
+#include "types.h"
+
+#define CONFIG_TESTS_MAX    128     // longest tests= list kept, with its NUL
+#define CONFIG_LIST_SEP     ','     // separates the names in tests=
+#define CONFIG_ALL          "all"   // tests=all runs every boot test
+
+// Knobs that can change per boot without a rebuild, set from the multiboot
+// command line by config_parse, e.g.
+//     quantum=4 tickless=0 terminals=1 procs=16 line=80 trace=0 profile=1 scrollback=1000 tests=fork_bench
+// Anything not given keeps the compile time default
+typedef struct kernel_config {
+    uint32_t pit_hz;            // quantum=<ms>, the scheduler time slice
+    uint8_t tickless;           // tickless=<0|1>, stop the PIT tick while idle
+    uint8_t terminals;          // terminals=<1..MAX_TERMINALS>, shells started
+    uint32_t max_processes;     // procs=<n>, cap on the process table, 0 for no cap
+    uint32_t line_limit;        // line=<n>, longest line the keyboard takes
+    uint8_t trace;              // trace=<0|1>, boot information on the console
+    uint8_t profile;            // profile=<0|1>, sample the PIT from boot
+    uint32_t scrollback;        // scrollback=<rows>, history each terminal keeps
+    int8_t tests[CONFIG_TESTS_MAX]; // tests=<name,name,...>, run before the shells
+} kernel_config_t;
+
+extern kernel_config_t kernel_config;
+
+// Prints like printf when trace is on
+#define tracef(...)                             \
+do {                                            \
+    if (kernel_config.trace) {                  \
+        printf(__VA_ARGS__);                    \
+    }                                           \
+} while (0)
+
+// Fills kernel_config from the boot command line
+extern void config_parse(const int8_t* cmdline);
+
+// Whether tests= names a test, or is "all"
+extern int32_t config_selects(const int8_t* name);
+
+#endif
@@ -0,0 +1,349 @@
+#include "console.h"
+#include "config.h"
+#include "frame_alloc.h"
+
+// Until console_scrollback_init has frames to give, each terminal has a
+// ring the size of the screen and no history
+static uint16_t console_boot_cells[MAX_TERMINALS][CONSOLE_CELLS];
+
+console_t consoles[MAX_TERMINALS] = {
+    { console_boot_cells[0], NUM_ROWS },
+    { console_boot_cells[1], NUM_ROWS },
+    { console_boot_cells[2], NUM_ROWS }
+};
+
+// Terminal t owns CONSOLE_REGION_CELLS of video memory from cell
+// t * CONSOLE_REGION_CELLS, and its screen is a window into them. Scrolling
+// moves the window down a row instead of copying the screen up, until it
+// reaches the end of the region and starts over at 0
+
+static void console_blank_row(console_t* console, uint32_t row, uint8_t attrib);
+static void console_show(uint8_t terminal);
+static uint32_t console_start(uint8_t terminal);
+
+/* console_write
+ * DESCRIPTION: Does what putc does for every byte, a run at a time. A run
+ *              is the characters up to the next newline or the end of the
+ *              row, and goes into the shadow screen in one loop with the
+ *              attribute already shifted into place, marking its row dirty
+ *              once. The cursor position is read and stored once a run,
+ *              so another writer on the terminal stays in step
+ * INPUTS: terminal - terminal to write to
+ *         buf - characters, '\n' and '\r' start a new line
+ *         nbytes - number of characters
+ *         attrib - attribute of the characters
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Moves the terminal's cursor position, may scroll
+ */
+void console_write(uint8_t terminal, const uint8_t* buf, uint32_t nbytes, uint8_t attrib) {
+    console_t* console = &consoles[terminal];
+    uint16_t attrib_word = attrib << CONSOLE_ATTRIB_SHIFT;
+    uint32_t i = 0, x, y, row, run, room;
+    uint16_t* cells;
+
+    while (i < nbytes) {
+        x = sscreenx[terminal];
+        y = sscreeny[terminal];
+        if (buf[i] == '\n' || buf[i] == '\r') {
+            i++;
+        } else {
+            row = console->top + y;
+            if (row >= console->rows) { row -= console->rows; }
+            cells = &console->cells[row * NUM_COLS + x];
+            room = (nbytes - i < NUM_COLS - x) ? nbytes - i : NUM_COLS - x;
+            for (run = 0; run < room && buf[i + run] != '\n' && buf[i + run] != '\r'; run++) {
+                cells[run] = buf[i + run] | attrib_word;
+            }
+            console->dirty |= 1 << y;
+            i += run;
+            x += run;
+            if (x < NUM_COLS) {
+                sscreenx[terminal] = x;
+                continue;
+            }
+        }
+
+        // a newline, or the run filled the row
+        if (y == NUM_ROWS - 1) { console_scroll(terminal, attrib); }
+        else { y++; }
+        sscreenx[terminal] = 0;
+        sscreeny[terminal] = y;
+    }
+}
+
+/* console_scroll
+ * DESCRIPTION: Moves the top of the ring down a row, so the old top row
+ *              becomes the newest row of history, and blanks the row that
+ *              comes in at the bottom, which was the oldest row of history.
+ *              Nothing else moves however much history is kept. The dirty
+ *              rows move up with the text, the bottom row is new.
+ *              Interrupts are off so a flush from the keyboard can't lose
+ *              a scroll
+ * INPUTS: terminal - terminal to scroll
+ *         attrib - attribute of the blank row
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void console_scroll(uint8_t terminal, uint8_t attrib) {
+    console_t* console = &consoles[terminal];
+    uint32_t flags, row;
+
+    cli_and_save(flags);
+    console->top = (console->top + 1 == console->rows) ? 0 : console->top + 1;
+    row = console->top + NUM_ROWS - 1;
+    if (row >= console->rows) { row -= console->rows; }
+    console_blank_row(console, row, attrib);
+    if (console->history < console->rows - NUM_ROWS) { console->history++; }
+    console->dirty = (console->dirty >> 1) | CONSOLE_LAST_ROW;
+    console->scrolled++;
+    restore_flags(flags);
+}
+
+/* console_clear
+ * DESCRIPTION: Blanks every row of a terminal's shadow screen and shows
+ *              the live screen. The history above it is kept
+ * INPUTS: terminal - terminal to clear
+ *         attrib - attribute of the blank cells
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void console_clear(uint8_t terminal, uint8_t attrib) {
+    console_t* console = &consoles[terminal];
+    uint32_t y, row = console->top;
+    for (y = 0; y < NUM_ROWS; y++) {
+        console_blank_row(console, row, attrib);
+        row = (row + 1 == console->rows) ? 0 : row + 1;
+    }
+    console->view = 0;
+    console->dirty = CONSOLE_ALL_ROWS;
+    console->cursor_moved = 1;
+}
+
+/* console_flush
+ * DESCRIPTION: Copies the rows changed since the last flush into the
+ *              terminal's region of video memory a cell at a time and
+ *              moves the hardware cursor once if it should follow. Shown
+ *              or not, a terminal scrolls by moving its window down, so
+ *              only the new rows are written, unless the window would run
+ *              past the end of the region and the whole screen is written
+ *              at the start again. A screen scrolled back into the history
+ *              stays on the same lines while the terminal prints below
+ *              them, and is rewritten whole when they move up the ring.
+ *              Interrupts stay off so a terminal switch can't move the
+ *              screen in the middle
+ * INPUTS: terminal - terminal to flush
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Writes to video memory, may move the window and cursor
+ */
+void console_flush(uint8_t terminal) {
+    console_t* console = &consoles[terminal];
+    uint32_t flags, dirty, y, x, row, window;
+    uint16_t* screen;
+    uint16_t* cells;
+
+    cli_and_save(flags);
+    dirty = console->dirty;
+    if (console->view != 0) {
+        if (console->scrolled != 0) {
+            console->view += console->scrolled;
+            if (console->view > console->history) { console->view = console->history; }
+            dirty = CONSOLE_ALL_ROWS;
+        } else if (console->view < NUM_ROWS) {
+            // live row y is on the screen view rows further down
+            dirty = (dirty << console->view) & CONSOLE_ALL_ROWS;
+        } else {
+            dirty = 0;
+        }
+    } else if (console->scrolled != 0) {
+        window = console->window + console->scrolled * NUM_COLS;
+        if (console->scrolled >= NUM_ROWS || window + CONSOLE_CELLS > CONSOLE_REGION_CELLS) {
+            window = 0;
+            dirty = CONSOLE_ALL_ROWS;
+        }
+        console->window = window;
+        if (terminal == cur_terminal) { console_show(terminal); }
+    }
+    screen = (uint16_t*)VIDEO + console_start(terminal);
+    console->dirty = 0;
+    console->scrolled = 0;
+
+    row = console->top + console->rows - console->view;
+    if (row >= console->rows) { row -= console->rows; }
+    for (y = 0; dirty != 0; y++, dirty >>= 1) {
+        if (dirty & 1) {
+            cells = &console->cells[row * NUM_COLS];
+            for (x = 0; x < NUM_COLS; x++) { screen[y * NUM_COLS + x] = cells[x]; }
+        }
+        row = (row + 1 == console->rows) ? 0 : row + 1;
+    }
+
+    if (console->cursor_moved && terminal == cur_terminal) {
+        console->cursor_moved = 0;
+        // scrolled far enough back the cursor is below the screen, where
+        // it can't be seen
+        y = sscreeny[terminal] + console->view;
+        if (y >= NUM_ROWS) { flashy_set(console_start(terminal) + CONSOLE_CELLS); }
+        else { flashy_set(console_start(terminal) + sscreenx[terminal] + y * NUM_COLS); }
+    }
+    restore_flags(flags);
+}
+
+/* console_home
+ * DESCRIPTION: Rewrites a terminal's live screen at the start of its
+ *              region and moves the window there, where vidmap pages
+ *              expect the screen to be
+ * INPUTS: terminal - terminal of the vidmap program
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Writes to video memory, moves the window and cursor
+ */
+void console_home(uint8_t terminal) {
+    console_t* console = &consoles[terminal];
+    uint32_t flags;
+    cli_and_save(flags);
+    if (console->view != 0) {
+        console->view = 0;
+        console->dirty = CONSOLE_ALL_ROWS;
+        console->cursor_moved = 1;
+    }
+    if (console->window != 0) {
+        console->window = 0;
+        console->dirty = CONSOLE_ALL_ROWS;
+        console->cursor_moved = 1;
+        if (terminal == cur_terminal) { console_show(terminal); }
+    }
+    console_flush(terminal);
+    restore_flags(flags);
+}
+
+/* console_switch
+ * DESCRIPTION: Shows a terminal by pointing the CRTC at its window and the
+ *              cursor at its cursor position, after writing out whatever
+ *              it printed since its last flush. Every terminal is already
+ *              in its own region of video memory, vidmap pages included,
+ *              so nothing is copied and the time doesn't depend on what is
+ *              on the screens. Called once cur_terminal is the new terminal
+ * INPUTS: terminal - terminal to show
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Writes to video memory, moves the window and cursor
+ */
+void console_switch(uint8_t terminal) {
+    uint32_t flags;
+    cli_and_save(flags);
+    consoles[terminal].cursor_moved = 1;
+    console_flush(terminal);
+    console_show(terminal);
+    restore_flags(flags);
+}
+
+/* console_scrollback_init
+ * DESCRIPTION: Moves every terminal from its boot ring to one with
+ *              kernel_config.scrollback rows of history, taken from the
+ *              frame allocator. What is on a screen stays on it, a
+ *              terminal that can't get the frames keeps its boot ring
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Allocates frames
+ */
+void console_scrollback_init() {
+    console_t* console;
+    uint32_t flags, terminal, order, rows, y, row;
+    uint16_t* cells;
+
+    rows = NUM_ROWS + kernel_config.scrollback;
+    for (order = 0; (FRAME_SIZE << order) < rows * CONSOLE_ROW_SIZE; order++);
+    if (kernel_config.scrollback == 0 || order > FRAME_MAX_ORDER) { return; }
+
+    for (terminal = 0; terminal < MAX_TERMINALS; terminal++) {
+        console = &consoles[terminal];
+        cells = (uint16_t*)frame_alloc(order);
+        if (cells == NULL) { return; }
+
+        cli_and_save(flags);
+        row = console->top;
+        for (y = 0; y < NUM_ROWS; y++) {
+            memcpy(&cells[y * NUM_COLS], &console->cells[row * NUM_COLS], CONSOLE_ROW_SIZE);
+            row = (row + 1 == console->rows) ? 0 : row + 1;
+        }
+        console->cells = cells;
+        console->rows = rows;
+        console->top = 0;
+        console->history = 0;
+        console->view = 0;
+        restore_flags(flags);
+    }
+}
+
+/* console_view
+ * DESCRIPTION: Moves a terminal's screen back through its history by a
+ *              number of rows, or forward towards the live screen, and
+ *              rewrites it. Stops at the oldest row kept and at the live
+ *              screen
+ * INPUTS: terminal - terminal to scroll back
+ *         lines - rows to go back, negative to go forward
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Writes to video memory, may move the cursor
+ */
+void console_view(uint8_t terminal, int32_t lines) {
+    console_t* console = &consoles[terminal];
+    uint32_t flags;
+    int32_t view;
+
+    cli_and_save(flags);
+    view = (int32_t)console->view + lines;
+    if (view < 0) { view = 0; }
+    if (view > (int32_t)console->history) { view = console->history; }
+    if (view != console->view) {
+        console->view = view;
+        console->dirty = CONSOLE_ALL_ROWS;
+        console->cursor_moved = 1;
+    }
+    console_flush(terminal);
+    restore_flags(flags);
+}
+
+/* console_live
+ * DESCRIPTION: Brings a terminal scrolled back into its history back to
+ *              the live screen, for when something is typed into it
+ * INPUTS: terminal - terminal to show live
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Writes to video memory when the terminal was scrolled back
+ */
+void console_live(uint8_t terminal) {
+    if (consoles[terminal].view != 0) { console_view(terminal, -(int32_t)consoles[terminal].view); }
+}
+
+/* console_blank_row
+ * DESCRIPTION: Fills a ring row with spaces
+ * INPUTS: console - shadow screen
+ *         row - ring row
+ *         attrib - attribute of the spaces
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void console_blank_row(console_t* console, uint32_t row, uint8_t attrib) {
+    memset_word(&console->cells[row * NUM_COLS], ' ' | (attrib << CONSOLE_ATTRIB_SHIFT), NUM_COLS);
+}
+
+/* console_show
+ * DESCRIPTION: Tells the CRTC to show a terminal's window top left
+ * INPUTS: terminal - terminal to show
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void console_show(uint8_t terminal) {
+    uint32_t cell = console_start(terminal);
+    outb(CRTC_START_HIGH, CRTC_INDEX);
+    outb((cell >> 8) & 0xFF, CRTC_DATA);
+    outb(CRTC_START_LOW, CRTC_INDEX);
+    outb(cell & 0xFF, CRTC_DATA);
+}
+
+/* console_start
+ * DESCRIPTION: Finds the cell a terminal's screen starts at
+ * INPUTS: terminal - terminal
+ * OUTPUTS: start of the window, counted from VIDEO
+ * SIDE EFFECTS: NONE
+ */
+static uint32_t console_start(uint8_t terminal) {
+    return terminal * CONSOLE_REGION_CELLS + consoles[terminal].window;
+}
@@ -0,0 +1,92 @@
+#ifndef _CONSOLE_H
+#define _CONSOLE_H
+
+#include "lib.h"
+
+#define CONSOLE_CELLS       (NUM_ROWS * NUM_COLS)
+#define CONSOLE_ALL_ROWS    ((1 << NUM_ROWS) - 1)   // dirty mask with every row set
+#define CONSOLE_LAST_ROW    (1 << (NUM_ROWS - 1))   // dirty bit of the bottom row
+#define CONSOLE_CHAR_MASK   0xFF
+#define CONSOLE_ATTRIB_SHIFT 8                      // attribute byte of a cell
+#define CONSOLE_REGION_CELLS 0x1000                 // video memory each terminal owns, 8 kB
+#define CONSOLE_REGION_SIZE (CONSOLE_REGION_CELLS * 2)
+#define CONSOLE_REGION(terminal) (VIDEO + (terminal) * CONSOLE_REGION_SIZE)    // where vidmap maps a terminal
+#define CONSOLE_ROW_SIZE    (NUM_COLS * 2)          // bytes of a ring row
+#define CONSOLE_SCROLLBACK_DEFAULT 500              // rows of history kept above the screen
+#define CONSOLE_SCROLLBACK_MAX 4096                 // most the scrollback= knob takes
+#define CONSOLE_PAGE_ROWS   (NUM_ROWS - 1)          // rows Shift+PgUp/PgDn move, one stays in view
+
+// CRTC registers that pick which cell is shown top left
+#define CRTC_INDEX          0x3D4
+#define CRTC_DATA           0x3D5
+#define CRTC_START_HIGH     0x0C
+#define CRTC_START_LOW      0x0D
+
+/* testing constants */
+#define CONSOLE_BENCH_TICKS 80      // PIT ticks each writer runs for
+#define CONSOLE_BENCH_LINE  64      // bytes per line written, newline included
+#define CONSOLE_SCROLL_LINES 1000   // lines console_scroll_bench writes each way
+#define CONSOLE_BULK_BYTES  0x4000  // bytes console_bulk_bench prints each way
+#define CONSOLE_SWITCHES    40      // terminal switches console_switch_bench times each way
+#define CONSOLE_SWITCH_TICKS 2      // PIT ticks the busy writers get between switches
+#define CONSOLE_HISTORY_LINE 16     // longest line console_scrollback_test prints
+
+// Text of one terminal, kept in memory so characters don't go to video
+// memory one by one. The rows are a ring, screen row 0 is row top, so a
+// scroll doesn't move the others. The ring has more rows than the screen,
+// the ones above top are the history, and a scroll only reuses the oldest
+// of them for the new bottom row. Changed rows are marked in dirty and
+// copied out by console_flush, into the part of video memory the terminal
+// owns. Every terminal stays in video memory, so showing one only points
+// the CRTC at it
+typedef struct console {
+    uint16_t* cells;                // rows of cells, character in the low byte, attribute in the high
+    uint32_t rows;                  // rows in the ring, the screen's and the history's
+    uint32_t top;                   // ring row shown as screen row 0
+    uint32_t history;               // rows above top that were written and can be scrolled back to
+    volatile uint32_t view;         // rows the screen is scrolled back, 0 for the live screen
+    volatile uint32_t dirty;        // bit r set when screen row r changed since the last flush
+    volatile uint32_t scrolled;     // scrolls since the last flush
+    volatile uint8_t cursor_moved;  // the hardware cursor should follow on the next flush
+    uint32_t window;                // cell the screen starts at in the terminal's region
+} console_t;
+
+extern console_t consoles[MAX_TERMINALS];
+
+// Puts a character in a cell of a terminal's shadow screen
+static inline void console_put(uint8_t terminal, uint32_t x, uint32_t y, uint8_t c, uint8_t attrib) {
+    console_t* console = &consoles[terminal];
+    uint32_t row = console->top + y;
+    if (row >= console->rows) { row -= console->rows; }
+    console->cells[row * NUM_COLS + x] = c | (attrib << CONSOLE_ATTRIB_SHIFT);
+    console->dirty |= 1 << y;
+}
+
+// Writes a buffer to a terminal's shadow screen a run of characters at a time
+extern void console_write(uint8_t terminal, const uint8_t* buf, uint32_t nbytes, uint8_t attrib);
+
+// Scrolls a terminal's shadow screen up a row, the new row is blank
+extern void console_scroll(uint8_t terminal, uint8_t attrib);
+
+// Blanks a terminal's shadow screen
+extern void console_clear(uint8_t terminal, uint8_t attrib);
+
+// Copies the changed rows of a terminal to video memory
+extern void console_flush(uint8_t terminal);
+
+// Moves a terminal's screen back to the start of its region
+extern void console_home(uint8_t terminal);
+
+// Points the CRTC and cursor at a terminal
+extern void console_switch(uint8_t terminal);
+
+// Gives every terminal a ring with the history scrollback= asks for
+extern void console_scrollback_init();
+
+// Scrolls a terminal's screen back through its history, forward for negative lines
+extern void console_view(uint8_t terminal, int32_t lines);
+
+// Shows a terminal's live screen again
+extern void console_live(uint8_t terminal);
+
+#endif
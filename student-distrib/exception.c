@@ -10,164 +10,159 @@
 #include "exception.h"
 #include "lib.h"
 
-void exception_00() {
-    printf("EXCEPTION 00: DIVIDE BY ZERO\n");
+/* exception_signal
+ * DESCRIPTION: An exception in a user program with a handler for it raises
+ *              a signal, which is delivered on the way out of the
+ *              exception. Without a handler, with the signal masked while
+ *              a handler runs, or in the kernel, the current process is
+ *              halted the way every exception used to be, and only then is
+ *              the exception printed
+ * INPUTS: frame - registers saved by the exception stub
+ *         signum - SIGNAL_DIV_ZERO or SIGNAL_SEGFAULT
+ *         message - what to print when the process is halted
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: May halt the current process
+ */
+void exception_signal(interrupt_frame_t* frame, uint32_t signum, int8_t* message) {
+    pcb_t* pcb = find_pcb();
+    if (frame->cs == USER_CS && pcb != NULL && signal_exception(pcb, signum) == SUCCESS) { return; }
+    printf(message);
     halt(EXCEPTION);
 }
 
-void exception_01() {
-    printf("EXCEPTION 01: RESERVED FOR INTEL USE\n");
-    halt(EXCEPTION);
+void exception_00(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_DIV_ZERO, "EXCEPTION 00: DIVIDE BY ZERO\n");
 }
 
-void exception_02() {
-    printf("EXCEPTION 02: NON-MASKABLE INTERRUPT (NMI)\n");
-    halt(EXCEPTION);
+void exception_01(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 01: RESERVED FOR INTEL USE\n");
 }
 
-void exception_03() {
-    printf("EXCEPTION 03: KGDB BREAKPOINT\n");
-    halt(EXCEPTION);
+void exception_02(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 02: NON-MASKABLE INTERRUPT (NMI)\n");
 }
 
-void exception_04() {
-    printf("EXCEPTION 04: OVERFLOW\n");
-    halt(EXCEPTION);
+void exception_03(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 03: KGDB BREAKPOINT\n");
 }
 
-void exception_05() {
-    printf("EXCEPTION 05: BOUND RANGE EXCEEDED\n");
-    halt(EXCEPTION);
+void exception_04(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 04: OVERFLOW\n");
 }
 
-void exception_06() {
-    printf("EXCEPTION 06: INVALID OPCODE\n");
-    halt(EXCEPTION);
+void exception_05(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 05: BOUND RANGE EXCEEDED\n");
 }
 
-void exception_07() {
-    printf("EXCEPTION 07: DEVICE NOT AVAILABLE (NO MATH COPROCESSOR)\n");
-    halt(EXCEPTION);
+void exception_06(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 06: INVALID OPCODE\n");
 }
 
-void exception_08() {
-    printf("EXCEPTION 08: DOUBLE FAULT\n");
-    halt(EXCEPTION);
+void exception_07(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 07: DEVICE NOT AVAILABLE (NO MATH COPROCESSOR)\n");
 }
 
-void exception_09() {
-    printf("EXCEPTION 09: COPROCESSOR SEGMENT OVERRUN\n");
-    halt(EXCEPTION);
+void exception_08(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 08: DOUBLE FAULT\n");
 }
 
-void exception_0A() {
-    printf("EXCEPTION 0A: INVALID TSS\n");
-    halt(EXCEPTION);
+void exception_09(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 09: COPROCESSOR SEGMENT OVERRUN\n");
 }
 
-void exception_0B() {
-    printf("EXCEPTION 0B: SEGMENT NOT PRESENT\n");
-    halt(EXCEPTION);
+void exception_0A(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 0A: INVALID TSS\n");
 }
 
-void exception_0C() {
-    printf("EXCEPTION 0C: STACK-SEGMENT FAULT\n");
-    halt(EXCEPTION);
+void exception_0B(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 0B: SEGMENT NOT PRESENT\n");
 }
 
-void exception_0D() {
-    printf("EXCEPTION 0D: GENERAL PROTECTION FAULT\n");
-    halt(EXCEPTION);
+void exception_0C(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 0C: STACK-SEGMENT FAULT\n");
 }
 
-void exception_0E() {
-    printf("EXCEPTION 0E: PAGE FAULT\n");
-    halt(EXCEPTION);
+void exception_0D(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 0D: GENERAL PROTECTION FAULT\n");
 }
 
-void exception_0F() {
-    printf("EXCEPTION 0F: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_0E(interrupt_frame_t* frame) {
+    uint32_t fault_addr;
+    asm volatile ("movl %%cr2, %0" : "=r"(fault_addr));
+
+    // pages of a program are loaded the first time they are touched, and
+    // copied the first time a shared page is written
+    if (demand_page(fault_addr, frame->error_code) == SUCCESS) { return; }
+
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 0E: PAGE FAULT\n");
 }
 
-void exception_10() {
-    printf("EXCEPTION 10: x87 FPU FLOATING-POINT ERROR (MATH FAULT)\n");
-    halt(EXCEPTION);
+void exception_0F(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 0F: INTEL RESERVED\n");
 }
 
-void exception_11() {
-    printf("EXCEPTION 11: ALIGNMENT CHECK\n");
-    halt(EXCEPTION);
+void exception_10(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 10: x87 FPU FLOATING-POINT ERROR (MATH FAULT)\n");
 }
 
-void exception_12() {
-    printf("EXCEPTION 12: MACHINE CHECK\n");
-    halt(EXCEPTION);
+void exception_11(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 11: ALIGNMENT CHECK\n");
 }
 
-void exception_13() {
-    printf("EXCEPTION 13: SIMD FLOATING-POINT EXCEPTION\n");
-    halt(EXCEPTION);
+void exception_12(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 12: MACHINE CHECK\n");
 }
 
-void exception_14() {
-    printf("EXCEPTION 14: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_13(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 13: SIMD FLOATING-POINT EXCEPTION\n");
 }
 
-void exception_15() {
-    printf("EXCEPTION 15: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_14(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 14: INTEL RESERVED\n");
 }
 
-void exception_16() {
-    printf("EXCEPTION 16: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_15(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 15: INTEL RESERVED\n");
 }
 
-void exception_17() {
-    printf("EXCEPTION 17: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_16(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 16: INTEL RESERVED\n");
 }
 
-void exception_18() {
-    printf("EXCEPTION 18: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_17(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 17: INTEL RESERVED\n");
 }
 
-void exception_19() {
-    printf("EXCEPTION 19: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_18(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 18: INTEL RESERVED\n");
 }
 
-void exception_1A() {
-    printf("EXCEPTION 1A: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_19(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 19: INTEL RESERVED\n");
 }
 
-void exception_1B() {
-    printf("EXCEPTION 1B: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_1A(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 1A: INTEL RESERVED\n");
 }
 
-void exception_1C() {
-    printf("EXCEPTION 1C: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_1B(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 1B: INTEL RESERVED\n");
 }
 
-void exception_1D() {
-    printf("EXCEPTION 1D: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_1C(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 1C: INTEL RESERVED\n");
 }
 
-void exception_1E() {
-    printf("EXCEPTION 1E: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_1D(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 1D: INTEL RESERVED\n");
 }
 
-void exception_1F() {
-    printf("EXCEPTION 1F: INTEL RESERVED\n");
-    halt(EXCEPTION);
+void exception_1E(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 1E: INTEL RESERVED\n");
+}
+
+void exception_1F(interrupt_frame_t* frame) {
+    exception_signal(frame, SIGNAL_SEGFAULT, "EXCEPTION 1F: INTEL RESERVED\n");
 }
 
 
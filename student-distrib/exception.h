@@ -2,42 +2,52 @@
 #define _EXCEPTION_H
 
 #include "syscall.h"
+#include "signal.h"
 
 #define NUM_EXCEPTIONS 32
 
 #define EXCEPTION   0xFF
 
-extern void exception_00();
-extern void exception_01();
-extern void exception_02();
-extern void exception_03();
-extern void exception_04();
-extern void exception_05();
-extern void exception_06();
-extern void exception_07();
-extern void exception_08();
-extern void exception_09();
-extern void exception_0A();
-extern void exception_0B();
-extern void exception_0C();
-extern void exception_0D();
-extern void exception_0E();
-extern void exception_0F();
-extern void exception_10();
-extern void exception_11();
-extern void exception_12();
-extern void exception_13();
-extern void exception_14();
-extern void exception_15();
-extern void exception_16();
-extern void exception_17();
-extern void exception_18();
-extern void exception_19();
-extern void exception_1A();
-extern void exception_1B();
-extern void exception_1C();
-extern void exception_1D();
-extern void exception_1E();
-extern void exception_1F();
+// page fault error code bit, clear when the page was not present
+#define PF_PRESENT  0x1
+// page fault error code bit, set when the access was a write
+#define PF_WRITE    0x2
+
+// Raises signum for an exception a user handler can take, prints message
+// and halts otherwise
+extern void exception_signal(interrupt_frame_t* frame, uint32_t signum, int8_t* message);
+
+extern void exception_00(interrupt_frame_t* frame);
+extern void exception_01(interrupt_frame_t* frame);
+extern void exception_02(interrupt_frame_t* frame);
+extern void exception_03(interrupt_frame_t* frame);
+extern void exception_04(interrupt_frame_t* frame);
+extern void exception_05(interrupt_frame_t* frame);
+extern void exception_06(interrupt_frame_t* frame);
+extern void exception_07(interrupt_frame_t* frame);
+extern void exception_08(interrupt_frame_t* frame);
+extern void exception_09(interrupt_frame_t* frame);
+extern void exception_0A(interrupt_frame_t* frame);
+extern void exception_0B(interrupt_frame_t* frame);
+extern void exception_0C(interrupt_frame_t* frame);
+extern void exception_0D(interrupt_frame_t* frame);
+extern void exception_0E(interrupt_frame_t* frame);
+extern void exception_0F(interrupt_frame_t* frame);
+extern void exception_10(interrupt_frame_t* frame);
+extern void exception_11(interrupt_frame_t* frame);
+extern void exception_12(interrupt_frame_t* frame);
+extern void exception_13(interrupt_frame_t* frame);
+extern void exception_14(interrupt_frame_t* frame);
+extern void exception_15(interrupt_frame_t* frame);
+extern void exception_16(interrupt_frame_t* frame);
+extern void exception_17(interrupt_frame_t* frame);
+extern void exception_18(interrupt_frame_t* frame);
+extern void exception_19(interrupt_frame_t* frame);
+extern void exception_1A(interrupt_frame_t* frame);
+extern void exception_1B(interrupt_frame_t* frame);
+extern void exception_1C(interrupt_frame_t* frame);
+extern void exception_1D(interrupt_frame_t* frame);
+extern void exception_1E(interrupt_frame_t* frame);
+extern void exception_1F(interrupt_frame_t* frame);
 
 #endif
@@ -23,6 +23,21 @@ data_block_t* data_block_start; //ptr to start of data_block
 uint32_t curr_dentry_idx;
 dentry_t curr_file;
 
+/* hashed dentry index, built once by filesys_init */
+static uint32_t dentry_keys[MAX_DENTRIES][FNAME_WORDS];   //zero padded copy of every fname
+static uint8_t dentry_hash[DENTRY_HASH_SIZE];             //open addressed, dentry index + 1
+
+/* extent maps, built once by filesys_init */
+static extent_t extent_pool[MAX_EXTENTS];                 //runs of every inode, back to back
+static extent_map_t inode_extents[MAX_INODES];            //which runs belong to which inode
+static uint32_t extents_used;
+
+static int32_t fname_to_key(const uint8_t* fname, uint32_t* key);
+static uint32_t fname_hash(const uint32_t* key);
+static void dentry_hash_init(void);
+static void extent_maps_init(void);
+static int32_t read_data_blocks(inode_t* inode_local, uint32_t offset, uint8_t* buf, uint32_t nbytes);
+
 /*
  * filesys_init(uint32_t multiboot_module_addr)
  * Description: Initializes the file system
@@ -36,6 +51,100 @@ void filesys_init(uint32_t multiboot_module_addr){
     inode_start = (inode_t*)(boot_block + 1);                                  //offset boot block ptr 4kB to start of inodes
     data_block_start = (data_block_t*)(boot_block + boot_block->inodes_count + 1);  //offset boot block ptr to datablocks at the end of inodes
     curr_dentry_idx = 0;                                                            //initialize current directory to 0
+    dentry_hash_init();                                                             //index dentries by name
+    extent_maps_init();                                                             //find contiguous runs of blocks
+}
+
+/*
+ * extent_maps_init(void)
+ * Description: Splits every inode's block list into runs of physically
+ *              contiguous data blocks so read_data can copy a run at a time
+ * Inputs: NONE
+ * Outputs: NONE
+ * Side Effects: fills extent_pool and inode_extents. Inodes that reference a
+ *               bad block or don't fit in the pool are left without a map
+ */
+static void extent_maps_init(void){
+    uint32_t i, j;
+    uint32_t n_inodes = boot_block->inodes_count;
+    uint32_t n_blocks;
+    uint32_t block;
+    extent_t* run;
+    if(n_inodes > MAX_INODES){
+        n_inodes = MAX_INODES;
+    }
+    extents_used = 0;
+    for(i = 0; i < n_inodes; i++){
+        inode_extents[i].first = extents_used;
+        inode_extents[i].count = 0;
+        n_blocks = (inode_start[i].length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if(n_blocks > DATA_BLOCK_SIZE){
+            continue;
+        }
+        run = NULL;
+        for(j = 0; j < n_blocks; j++){
+            block = inode_start[i].data_block[j];
+            if(block >= boot_block->data_blocks_count){
+                break;                                  //corrupt inode, keep the slow path
+            }
+            /* extend the current run or start a new one */
+            if((run != NULL) && (block == run->start_block + run->num_blocks)){
+                run->num_blocks++;
+                continue;
+            }
+            if(extents_used == MAX_EXTENTS){
+                break;
+            }
+            run = &extent_pool[extents_used++];
+            run->start_block = block;
+            run->num_blocks = 1;
+            inode_extents[i].count++;
+        }
+        if(j < n_blocks){
+            /* give the pool entries back, this inode is read block by block */
+            extents_used = inode_extents[i].first;
+            inode_extents[i].count = 0;
+        }
+    }
+}
+
+/*
+ * dentry_hash_init(void)
+ * Description: Builds the name index over the boot block dentries. Every name
+ *              is stored as 8 zero padded words so lookups compare whole words
+ * Inputs: NONE
+ * Outputs: NONE
+ * Side Effects: fills dentry_keys and dentry_hash
+ */
+static void dentry_hash_init(void){
+    uint32_t i, j;
+    uint32_t bucket;
+    uint32_t n_dentries = boot_block->dentries_count;
+    if(n_dentries > MAX_DENTRIES){
+        n_dentries = MAX_DENTRIES;
+    }
+    for(i = 0; i < DENTRY_HASH_SIZE; i++){
+        dentry_hash[i] = DENTRY_HASH_EMPTY;
+    }
+    for(i = 0; i < n_dentries; i++){
+        /* names in the boot block are not NUL terminated when they are 32B long */
+        uint8_t* key_bytes = (uint8_t*)dentry_keys[i];
+        for(j = 0; j < FNAME_LEN && boot_block->dentries[i].fname[j] != '\0'; j++){
+            key_bytes[j] = boot_block->dentries[i].fname[j];
+        }
+        for(; j < FNAME_LEN; j++){
+            key_bytes[j] = '\0';
+        }
+        if(key_bytes[0] == '\0'){
+            continue;                                   //unnamed entries can never be looked up
+        }
+        /* linear probing, the first dentry with a name keeps the bucket closest to home */
+        bucket = fname_hash(dentry_keys[i]) & DENTRY_HASH_MASK;
+        while(dentry_hash[bucket] != DENTRY_HASH_EMPTY){
+            bucket = (bucket + 1) & DENTRY_HASH_MASK;
+        }
+        dentry_hash[bucket] = i + 1;
+    }
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~ END OF INITITIALIZATION ~~~~~~~~~~~~~~~~~~~~ */
@@ -55,32 +164,69 @@ int32_t read_dentry_by_name (const uint8_t* fname, dentry_t* dentry){
     if((fname==NULL)||(fname[0]=='\0')||(dentry==NULL)){
         return FAILURE;
     }
-    uint32_t fname_length;
-    fname_length = strlen((int8_t*)fname) + 1;      //strlen returns 0 indexed length, must add 1
-    /* if name is too big, use max fname length */
-    if (fname_length == FNAME_LEN + 1) { fname_length = FNAME_LEN; }
-    else if(fname_length > FNAME_LEN + 1){
-        return -1;
+    uint32_t key[FNAME_WORDS];
+    if(fname_to_key(fname, key) == FAILURE){
+        return FAILURE;                                 //name is too big
     }
-    uint32_t search_length;
+    uint32_t bucket = fname_hash(key) & DENTRY_HASH_MASK;
+    uint32_t idx;
     int i; //iterator
-    /* check directory entries in boot block */
-    for(i=0; i<(boot_block->dentries_count); i++){
-        search_length = strlen((const int8_t*)(boot_block->dentries[i].fname)) + 1; //strlen returns 0 indexed len, must add 1
-        /* if search name is too big, use max fname length */
-        if(search_length > FNAME_LEN){
-            search_length = (FNAME_LEN);
+    /* probe until an empty bucket, comparing 4B at a time */
+    while(dentry_hash[bucket] != DENTRY_HASH_EMPTY){
+        idx = dentry_hash[bucket] - 1;
+        for(i = 0; i < FNAME_WORDS; i++){
+            if(dentry_keys[idx][i] != key[i]){
+                break;
+            }
         }
-        /* check length is the same and name is the same*/
-        if((fname_length==search_length)&&(strncmp((const int8_t*)fname, (const int8_t*)(boot_block->dentries[i].fname), fname_length)==0)){
-            
-            return read_dentry_by_index(i, dentry);    //fill dentry data
+        if(i == FNAME_WORDS){
+            return read_dentry_by_index(idx, dentry);   //fill dentry data
         }
+        bucket = (bucket + 1) & DENTRY_HASH_MASK;
     }
     //printf("read_dentry_by_name failed\n");
     return FAILURE; //no file found
 }
 
+/*
+ * fname_to_key(const uint8_t* fname, uint32_t* key)
+ * Description: Copies a NUL terminated name into a zero padded 32B key
+ * Inputs: fname - name to convert
+ *         key - FNAME_WORDS words to be written to
+ * Outputs: SUCCESS, FAILURE if the name is longer than FNAME_LEN
+ * Side Effects: key written
+ */
+static int32_t fname_to_key(const uint8_t* fname, uint32_t* key){
+    uint8_t* key_bytes = (uint8_t*)key;
+    uint32_t i;
+    for(i = 0; i < FNAME_LEN && fname[i] != '\0'; i++){
+        key_bytes[i] = fname[i];
+    }
+    if(i == FNAME_LEN && fname[i] != '\0'){
+        return FAILURE;
+    }
+    for(; i < FNAME_LEN; i++){
+        key_bytes[i] = '\0';
+    }
+    return SUCCESS;
+}
+
+/*
+ * fname_hash(const uint32_t* key)
+ * Description: FNV-1a over the words of a padded name
+ * Inputs: key - FNAME_WORDS words of name
+ * Outputs: hash value
+ * Side Effects: none
+ */
+static uint32_t fname_hash(const uint32_t* key){
+    uint32_t hash = FNV_OFFSET_BASIS;
+    int i;
+    for(i = 0; i < FNAME_WORDS; i++){
+        hash = (hash ^ key[i]) * FNV_PRIME;
+    }
+    return hash ^ (hash >> 16);     //fold high bits in, the mask only keeps the low ones
+}
+
 /*
  * read_dentry_by_index (uint32_t index, dentry_t* dentry)
  * Description: copies statistics to dentry
@@ -124,49 +270,124 @@ int32_t read_data (uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t lengt
     if(offset>=inode_local->length){
         return 0;                               //At end of file, 0 bytes read
     }
-    uint32_t bytes_read = 0;                    //counter of bytes read
     uint32_t nbytes = length;   //number of bytes to read
     //find number of bytes to read
     if((inode_local->length - offset) < length){
         nbytes = inode_local->length - offset;
     }
+    if((inode >= MAX_INODES)||(inode_extents[inode].count == 0)){
+        return read_data_blocks(inode_local, offset, buf, nbytes);
+    }
+
+    extent_t* run = &extent_pool[inode_extents[inode].first];
+    uint32_t run_start = 0;                             //file offset of the start of run
+    uint32_t run_bytes = run->num_blocks * BLOCK_SIZE;
+    //skip the runs that end before offset
+    while(run_start + run_bytes <= offset){
+        run_start += run_bytes;
+        run++;
+        run_bytes = run->num_blocks * BLOCK_SIZE;
+    }
+    uint32_t bytes_read = 0;                    //counter of bytes read
+    uint32_t start = offset - run_start;        //offset w/ respect to the run
+    uint32_t copy_bytes;                        //number of bytes to copy
+    //one copy per run until end of file or required length
+    while(1){
+        copy_bytes = run_bytes - start;
+        if(nbytes - bytes_read < copy_bytes){
+            copy_bytes = nbytes - bytes_read;
+        }
+        memcpy(buf, data_block_start[run->start_block].data + start, copy_bytes);
+        bytes_read += copy_bytes;
+        if(bytes_read == nbytes){
+            break;
+        }
+        buf += copy_bytes;
+        start = 0;
+        run++;
+        run_bytes = run->num_blocks * BLOCK_SIZE;
+    }
+    return bytes_read;
+}
+
+/*
+ * read_data_blocks(inode_t* inode_local, uint32_t offset, uint8_t* buf, uint32_t nbytes)
+ * Description: Copies file data one data block at a time. Used for inodes
+ *              that don't have an extent map
+ * Inputs: inode_local - inode of file to be read
+ *         offset - position in file to start reading from, inside the file
+ *         buf - location to copy bytes to
+ *         nbytes - number of bytes to be read, already clipped to the file
+ * Outputs: number of bytes read
+ * Side Effects: data copied to buf
+ */
+static int32_t read_data_blocks(inode_t* inode_local, uint32_t offset, uint8_t* buf, uint32_t nbytes){
+    uint32_t bytes_read = 0;                    //counter of bytes read
     uint32_t data_block_idx = offset/BLOCK_SIZE;        //Find block
     uint32_t start = offset % BLOCK_SIZE;               //Find offset w/ respect to block
-    uint32_t end = start + nbytes;                      //end of bytes to be read
-    uint32_t i = start;
     uint32_t copy_bytes;                                //number of bytes to copy
     //loop until end of file or required length
-    while(i<end){
-        copy_bytes = BLOCK_SIZE;                        //bytes to copy should be either the size of the block
+    while(bytes_read<nbytes){
+        copy_bytes = BLOCK_SIZE - start;                //bytes to copy should be either the rest of the block
         if(nbytes - bytes_read < copy_bytes){           //or the number of bytes requested
             copy_bytes = nbytes - bytes_read;
         }
-        uint32_t increment = i % BLOCK_SIZE;
         //copy memory
-        memcpy(buf, data_block_start[inode_local->data_block[data_block_idx]].data + increment, copy_bytes);
+        memcpy(buf, data_block_start[inode_local->data_block[data_block_idx]].data + start, copy_bytes);
         //increment everything my number of bytes copied
         bytes_read += copy_bytes;
         buf += copy_bytes;
-        i += copy_bytes;
+        start = 0;
         data_block_idx++;
     }
-    //previous code
-    /*
-    while(bytes_read<length){
-        // if at end of file break
-        if(bytes_read+offset >= inode_local->length){
-            break;
+    return bytes_read;
+}
+
+/*
+ * file_length(uint32_t inode)
+ * Description: Gets the size of a file
+ * Inputs: inode - index node of file
+ * Outputs: length in bytes or FAILURE
+ * Side Effects: none
+ */
+int32_t file_length(uint32_t inode){
+    if(inode >= boot_block->inodes_count){
+        return FAILURE;
+    }
+    return inode_start[inode].length;
+}
+
+/*
+ * map_file_pages(uint32_t inode, uint32_t* table, uint32_t max_pages)
+ * Description: Fills page table entries so that consecutive 4kB pages map
+ *              the file's data blocks in place, read-only and user level.
+ *              The blocks already sit in memory as part of the multiboot
+ *              module, so nothing is copied
+ * Inputs: inode - index node of file to be mapped
+ *         table - first page table entry to fill
+ *         max_pages - number of entries available at table
+ * Outputs: number of pages mapped or FAILURE
+ * Side Effects: table entries written
+ */
+int32_t map_file_pages(uint32_t inode, uint32_t* table, uint32_t max_pages){
+    if((inode >= boot_block->inodes_count)||(table == NULL)){
+        return FAILURE;
+    }
+    inode_t* inode_local = &inode_start[inode];
+    uint32_t n_pages = (inode_local->length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t i;
+    if(n_pages > max_pages){
+        return FAILURE;
+    }
+    for(i = 0; i < n_pages; i++){
+        if(inode_local->data_block[i] >= boot_block->data_blocks_count){
+            return FAILURE;
         }
-        //calculate idx for data_block
-        data_block_idx = (bytes_read + offset)/BLOCK_SIZE;
-        //calculate buf ptr
-        buf_ptr = data_block_start[inode_local->data_block[data_block_idx]].data + ((bytes_read+offset)%BLOCK_SIZE);
-        // copy data
-        buf[bytes_read] = *buf_ptr;
-        bytes_read++;
     }
-    */
-    return bytes_read;
+    for(i = 0; i < n_pages; i++){
+        table[i] = (uint32_t)&data_block_start[inode_local->data_block[i]] | FLAG_P | FLAG_US;
+    }
+    return n_pages;
 }
 
 /*
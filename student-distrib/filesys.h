@@ -20,11 +20,27 @@
 #define DENTRY_SIZE         64       //64B
 #define MAX_DENTRIES        63
 #define DATA_BLOCK_SIZE     1023
+#define FNAME_WORDS         (FNAME_LEN / LONG)   //fname compared as 8 4B words
+
+/* dentry hash index constants */
+#define DENTRY_HASH_SIZE    128      //power of 2, at least twice MAX_DENTRIES
+#define DENTRY_HASH_MASK    (DENTRY_HASH_SIZE - 1)
+#define DENTRY_HASH_EMPTY   0        //buckets hold dentry index + 1
+#define FNV_OFFSET_BASIS    2166136261U
+#define FNV_PRIME           16777619U
+
+/* extent map constants */
+#define MAX_INODES          256      //inodes past this are read block by block
+#define MAX_EXTENTS         2048     //shared pool of runs for every inode
 
 /* testing constants */
 #define ARBITRARY_BUFFER_SIZE 33
 #define MAGIC_NUMBER_OFFSET   100
 #define BIG_BUF_SIZE          100000
+#define LOOKUP_BENCH_ROUNDS   1000
+#define ODD_CHUNK_SIZE        1000
+#define MMAP_BENCH_ROUNDS     100
+#define ELF_HEADER_SIZE       28
 
 /* structs */
 typedef struct {
@@ -51,6 +67,16 @@ typedef struct {
     uint8_t data[BLOCK_SIZE];                 //4kB data
 } data_block_t;
 
+typedef struct {
+    uint32_t start_block;                     //first data block of the run
+    uint32_t num_blocks;                      //number of physically contiguous blocks
+} extent_t;
+
+typedef struct {
+    uint32_t first;                           //index of first run in the extent pool
+    uint32_t count;                           //number of runs, 0 if the inode has no map
+} extent_map_t;
+
 /* file system initialization */
 void filesys_init(uint32_t multiboot_module_addr);
 
@@ -59,6 +85,8 @@ int32_t read_dentry_by_name (const uint8_t* fname, dentry_t* dentry);
 int32_t read_dentry_by_index (uint32_t index, dentry_t* dentry);
 int32_t read_data (uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length);
 inode_t get_inode(uint32_t inode_idx);
+int32_t file_length(uint32_t inode);
+int32_t map_file_pages(uint32_t inode, uint32_t* table, uint32_t max_pages);
 
 /* directory functions */
 extern int32_t directory_open(const uint8_t* filename);
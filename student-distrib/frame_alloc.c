@@ -0,0 +1,241 @@
+#include "frame_alloc.h"
+
+// heads of the free lists, one per block size
+static free_block_t* free_lists[FRAME_MAX_ORDER + 1];
+
+// order + 1 for frames that start a free block, 0 for every other frame
+static uint8_t free_order[FRAME_COUNT];
+
+// number of page tables mapping each user frame, 1 from frame_alloc
+static uint16_t frame_refs[FRAME_COUNT];
+
+static uint32_t free_frames = 0;
+static uint32_t total_frames = 0;
+
+static void frame_list_push(uint32_t addr, uint32_t order);
+static void frame_list_remove(uint32_t addr, uint32_t order);
+static void frame_add_region(multiboot_info_t* mbi, uint32_t start, uint32_t end);
+static void frame_add_range(uint32_t start, uint32_t end);
+
+/* frame_init
+ * DESCRIPTION: Walks the multiboot memory map and hands every available
+ *              frame between FRAME_MEM_START and FRAME_MEM_END to the
+ *              allocator, skipping the boot modules. Falls back to mem_upper
+ *              when there is no memory map. Runs with paging off, and the
+ *              direct map keeps the same addresses once paging is on
+ * INPUTS: mbi - multiboot information from the boot loader
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Fills the free lists
+ */
+void frame_init(multiboot_info_t* mbi) {
+    if (mbi->flags & MBI_FLAG_MMAP) {
+        memory_map_t* mmap;
+        for (mmap = (memory_map_t*)mbi->mmap_addr;
+                (uint32_t)mmap < mbi->mmap_addr + mbi->mmap_length;
+                mmap = (memory_map_t*)((uint32_t)mmap + mmap->size + sizeof(mmap->size))) {
+            if (mmap->type != MMAP_AVAILABLE || mmap->base_addr_high != 0) { continue; }
+            uint32_t end = mmap->base_addr_low + mmap->length_low;
+            if (mmap->length_high != 0 || end < mmap->base_addr_low) { end = FRAME_MEM_END; }
+            frame_add_region(mbi, mmap->base_addr_low, end);
+        }
+    } else if (mbi->flags & MBI_FLAG_MEM) {
+        frame_add_region(mbi, MEGABYTE, MEGABYTE + mbi->mem_upper * KILOBYTE);
+    }
+}
+
+/* frame_alloc
+ * DESCRIPTION: Takes the smallest free block that fits and splits it down
+ *              to the requested size, putting the unused halves back
+ * INPUTS: order - log2 of the number of frames wanted
+ * OUTPUTS: physical (and direct mapped) address of the block, 0 on failure
+ * SIDE EFFECTS: NONE
+ */
+uint32_t frame_alloc(uint32_t order) {
+    uint32_t flags;
+    uint32_t cur;
+    if (order > FRAME_MAX_ORDER) { return 0; }
+
+    cli_and_save(flags);
+    for (cur = order; cur <= FRAME_MAX_ORDER && free_lists[cur] == NULL; cur++);
+    if (cur > FRAME_MAX_ORDER) {
+        restore_flags(flags);
+        return 0;
+    }
+
+    uint32_t addr = (uint32_t)free_lists[cur];
+    frame_list_remove(addr, cur);
+    while (cur > order) {
+        cur--;
+        frame_list_push(addr + (FRAME_SIZE << cur), cur);
+    }
+    free_frames -= (1 << order);
+    frame_refs[addr >> FRAME_SHIFT] = 1;
+    restore_flags(flags);
+    return addr;
+}
+
+/* frame_free
+ * DESCRIPTION: Puts a block back, merging it with its buddy for as long as
+ *              the buddy is free too
+ * INPUTS: addr - address returned by frame_alloc
+ *         order - order it was allocated with
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void frame_free(uint32_t addr, uint32_t order) {
+    uint32_t flags;
+    if (addr < FRAME_MEM_START || addr >= FRAME_MEM_END || order > FRAME_MAX_ORDER) { return; }
+
+    cli_and_save(flags);
+    frame_refs[addr >> FRAME_SHIFT] = 0;
+    free_frames += (1 << order);
+    while (order < FRAME_MAX_ORDER) {
+        uint32_t buddy = addr ^ (FRAME_SIZE << order);
+        if (buddy < FRAME_MEM_START || buddy >= FRAME_MEM_END || free_order[buddy >> FRAME_SHIFT] != order + 1) { break; }
+        frame_list_remove(buddy, order);
+        if (buddy < addr) { addr = buddy; }
+        order++;
+    }
+    frame_list_push(addr, order);
+    restore_flags(flags);
+}
+
+/* frame_get
+ * DESCRIPTION: Takes another reference on a single frame, for a page that
+ *              fork leaves mapped in both processes
+ * INPUTS: addr - frame from frame_alloc(0)
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void frame_get(uint32_t addr) {
+    uint32_t flags;
+    if (addr < FRAME_MEM_START || addr >= FRAME_MEM_END) { return; }
+    cli_and_save(flags);
+    frame_refs[addr >> FRAME_SHIFT]++;
+    restore_flags(flags);
+}
+
+/* frame_put
+ * DESCRIPTION: Drops a reference on a single frame, freeing it with the
+ *              last one
+ * INPUTS: addr - frame from frame_alloc(0)
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: May free the frame
+ */
+void frame_put(uint32_t addr) {
+    uint32_t flags;
+    if (addr < FRAME_MEM_START || addr >= FRAME_MEM_END) { return; }
+    cli_and_save(flags);
+    if (frame_refs[addr >> FRAME_SHIFT] <= 1) { frame_free(addr, 0); }
+    else { frame_refs[addr >> FRAME_SHIFT]--; }
+    restore_flags(flags);
+}
+
+/* frame_ref_count
+ * DESCRIPTION: Reports how many page tables map a frame
+ * INPUTS: addr - frame from frame_alloc(0)
+ * OUTPUTS: reference count, 0 for free frames
+ * SIDE EFFECTS: NONE
+ */
+uint32_t frame_ref_count(uint32_t addr) {
+    if (addr < FRAME_MEM_START || addr >= FRAME_MEM_END) { return 0; }
+    return frame_refs[addr >> FRAME_SHIFT];
+}
+
+/* frame_free_count
+ * DESCRIPTION: Reports how many frames are free
+ * INPUTS: NONE
+ * OUTPUTS: number of free 4KB frames
+ * SIDE EFFECTS: NONE
+ */
+uint32_t frame_free_count() {
+    return free_frames;
+}
+
+/* frame_total_count
+ * DESCRIPTION: Reports how many frames the memory map gave the allocator
+ * INPUTS: NONE
+ * OUTPUTS: number of managed 4KB frames
+ * SIDE EFFECTS: NONE
+ */
+uint32_t frame_total_count() {
+    return total_frames;
+}
+
+/* frame_list_push
+ * DESCRIPTION: Adds a block to the front of its free list
+ * INPUTS: addr - start of the block
+ *         order - size of the block
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Writes the list links into the block
+ */
+static void frame_list_push(uint32_t addr, uint32_t order) {
+    free_block_t* block = (free_block_t*)addr;
+    block->prev = NULL;
+    block->next = free_lists[order];
+    if (block->next != NULL) { block->next->prev = block; }
+    free_lists[order] = block;
+    free_order[addr >> FRAME_SHIFT] = order + 1;
+}
+
+/* frame_list_remove
+ * DESCRIPTION: Unlinks a block from its free list
+ * INPUTS: addr - start of the block
+ *         order - size of the block
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void frame_list_remove(uint32_t addr, uint32_t order) {
+    free_block_t* block = (free_block_t*)addr;
+    if (block->prev != NULL) { block->prev->next = block->next; }
+    else { free_lists[order] = block->next; }
+    if (block->next != NULL) { block->next->prev = block->prev; }
+    free_order[addr >> FRAME_SHIFT] = 0;
+}
+
+/* frame_add_region
+ * DESCRIPTION: Clips a usable region to the managed range and adds the
+ *              parts that no boot module occupies
+ * INPUTS: mbi - multiboot information, for the module list
+ *         start, end - usable physical range
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void frame_add_region(multiboot_info_t* mbi, uint32_t start, uint32_t end) {
+    if (start < FRAME_MEM_START) { start = FRAME_MEM_START; }
+    if (end > FRAME_MEM_END) { end = FRAME_MEM_END; }
+    start = (start + FRAME_SIZE - 1) & ~(FRAME_SIZE - 1);
+    end &= ~(FRAME_SIZE - 1);
+
+    uint32_t addr, run_start = start;
+    for (addr = start; addr < end; addr += FRAME_SIZE) {
+        uint32_t i;
+        module_t* mod = (module_t*)mbi->mods_addr;
+        uint8_t used = 0;
+        for (i = 0; (mbi->flags & MBI_FLAG_MODS) && i < mbi->mods_count; i++, mod++) {
+            if (addr < mod->mod_end && addr + FRAME_SIZE > mod->mod_start) { used = 1; }
+        }
+        if (used) {
+            frame_add_range(run_start, addr);
+            run_start = addr + FRAME_SIZE;
+        }
+    }
+    frame_add_range(run_start, end);
+}
+
+/* frame_add_range
+ * DESCRIPTION: Frees a range of frames as the largest aligned blocks that
+ *              fit in it
+ * INPUTS: start, end - frame aligned physical range
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void frame_add_range(uint32_t start, uint32_t end) {
+    while (start < end) {
+        uint32_t order = FRAME_MAX_ORDER;
+        while ((start & ((FRAME_SIZE << order) - 1)) != 0 || start + (FRAME_SIZE << order) > end) { order--; }
+        frame_free(start, order);
+        total_frames += (1 << order);
+        start += FRAME_SIZE << order;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef _FRAME_ALLOC_H
+#define _FRAME_ALLOC_H
+
+#include "types.h"
+#include "lib.h"
+#include "multiboot.h"
+
+#define FRAME_SIZE          FOUR_KB
+#define FRAME_SHIFT         12
+#define FRAME_MAX_ORDER     10                  // largest block is 4MB
+#define FRAME_MEM_START     EIGHT_MB            // below here belongs to the kernel image and boot stack
+#define FRAME_MEM_END       (128*MEGABYTE)      // end of the kernel's direct map
+#define FRAME_COUNT         (FRAME_MEM_END >> FRAME_SHIFT)
+#define MMAP_AVAILABLE      1                   // memory map type of usable RAM
+#define MBI_FLAG_MEM        0x01                // mem_lower and mem_upper are valid
+#define MBI_FLAG_MODS       0x08                // mods_addr and mods_count are valid
+#define MBI_FLAG_MMAP       0x40                // mmap_addr and mmap_length are valid
+
+// Free blocks are kept on per-order lists linked through their first bytes
+typedef struct free_block {
+    struct free_block* next;
+    struct free_block* prev;
+} free_block_t;
+
+// Frees every usable frame the boot loader reports, must run before paging
+extern void frame_init(multiboot_info_t* mbi);
+
+// Allocates 2^order contiguous, aligned frames, returns 0 when out of memory
+extern uint32_t frame_alloc(uint32_t order);
+
+// Returns 2^order frames from frame_alloc
+extern void frame_free(uint32_t addr, uint32_t order);
+
+// Reference counting for single frames mapped by more than one process
+extern void frame_get(uint32_t addr);
+extern void frame_put(uint32_t addr);
+extern uint32_t frame_ref_count(uint32_t addr);
+
+// Number of frames currently free
+extern uint32_t frame_free_count();
+
+// Number of frames the allocator manages
+extern uint32_t frame_total_count();
+
+#endif
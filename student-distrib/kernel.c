@@ -14,9 +14,17 @@
 #include "paging.h"
 #include "syscall.h"
 #include "filesys.h"
+#include "page_cache.h"
+#include "frame_alloc.h"
+#include "slab.h"
+#include "pipe.h"
+#include "timer.h"
 #include "multi_term.h"
 #include "scheduler.h"
 #include "pit.h"
+#include "config.h"
+#include "profile.h"
+#include "console.h"
 
 #define RUN_TESTS
 
@@ -42,20 +50,24 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Set MBI to the address of the Multiboot information structure. */
     mbi = (multiboot_info_t *) addr;
 
+    /* Read the boot tunables before anything they size is set up */
+    if (CHECK_FLAG(mbi->flags, 2))
+        config_parse((int8_t *)mbi->cmdline);
+
     /* Print out the flags. */
-    printf("flags = 0x%#x\n", (unsigned)mbi->flags);
+    tracef("flags = 0x%#x\n", (unsigned)mbi->flags);
 
     /* Are mem_* valid? */
     if (CHECK_FLAG(mbi->flags, 0))
-        printf("mem_lower = %uKB, mem_upper = %uKB\n", (unsigned)mbi->mem_lower, (unsigned)mbi->mem_upper);
+        tracef("mem_lower = %uKB, mem_upper = %uKB\n", (unsigned)mbi->mem_lower, (unsigned)mbi->mem_upper);
 
     /* Is boot_device valid? */
     if (CHECK_FLAG(mbi->flags, 1))
-        printf("boot_device = 0x%#x\n", (unsigned)mbi->boot_device);
+        tracef("boot_device = 0x%#x\n", (unsigned)mbi->boot_device);
 
     /* Is the command line passed? */
     if (CHECK_FLAG(mbi->flags, 2))
-        printf("cmdline = %s\n", (char *)mbi->cmdline);
+        tracef("cmdline = %s\n", (char *)mbi->cmdline);
 
     if (CHECK_FLAG(mbi->flags, 3)) {
         int mod_count = 0;
@@ -63,13 +75,13 @@ void entry(unsigned long magic, unsigned long addr) {
         module_t* mod = (module_t*)mbi->mods_addr;
         boot_block_addr = (uint32_t)mod->mod_start;
         while (mod_count < mbi->mods_count) {
-            printf("Module %d loaded at address: 0x%#x\n", mod_count, (unsigned int)mod->mod_start);
-            printf("Module %d ends at address: 0x%#x\n", mod_count, (unsigned int)mod->mod_end);
-            printf("First few bytes of module:\n");
+            tracef("Module %d loaded at address: 0x%#x\n", mod_count, (unsigned int)mod->mod_start);
+            tracef("Module %d ends at address: 0x%#x\n", mod_count, (unsigned int)mod->mod_end);
+            tracef("First few bytes of module:\n");
             for (i = 0; i < 16; i++) {
-                printf("0x%x ", *((char*)(mod->mod_start+i)));
+                tracef("0x%x ", *((char*)(mod->mod_start+i)));
             }
-            printf("\n");
+            tracef("\n");
             mod_count++;
             mod++;
         }
@@ -83,7 +95,7 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Is the section header table of ELF valid? */
     if (CHECK_FLAG(mbi->flags, 5)) {
         elf_section_header_table_t *elf_sec = &(mbi->elf_sec);
-        printf("elf_sec: num = %u, size = 0x%#x, addr = 0x%#x, shndx = 0x%#x\n",
+        tracef("elf_sec: num = %u, size = 0x%#x, addr = 0x%#x, shndx = 0x%#x\n",
                 (unsigned)elf_sec->num, (unsigned)elf_sec->size,
                 (unsigned)elf_sec->addr, (unsigned)elf_sec->shndx);
     }
@@ -91,12 +103,12 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Are mmap_* valid? */
     if (CHECK_FLAG(mbi->flags, 6)) {
         memory_map_t *mmap;
-        printf("mmap_addr = 0x%#x, mmap_length = 0x%x\n",
+        tracef("mmap_addr = 0x%#x, mmap_length = 0x%x\n",
                 (unsigned)mbi->mmap_addr, (unsigned)mbi->mmap_length);
         for (mmap = (memory_map_t *)mbi->mmap_addr;
                 (unsigned long)mmap < mbi->mmap_addr + mbi->mmap_length;
                 mmap = (memory_map_t *)((unsigned long)mmap + mmap->size + sizeof (mmap->size)))
-            printf("    size = 0x%x, base_addr = 0x%#x%#x\n    type = 0x%x,  length    = 0x%#x%#x\n",
+            tracef("    size = 0x%x, base_addr = 0x%#x%#x\n    type = 0x%x,  length    = 0x%#x%#x\n",
                     (unsigned)mmap->size,
                     (unsigned)mmap->base_addr_high,
                     (unsigned)mmap->base_addr_low,
@@ -105,6 +117,11 @@ void entry(unsigned long magic, unsigned long addr) {
                     (unsigned)mmap->length_low);
     }
 
+    /* Hand the usable memory to the frame allocator while paging is off */
+    frame_init(mbi);
+    tracef("%u frames of memory available\n", frame_total_count());
+    slab_init();
+
     /* Construct an LDT entry in the GDT */
     {
         seg_desc_t the_ldt_desc;
@@ -173,6 +190,16 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Initialize filesys */
     filesys_init(boot_block_addr);
 
+    /* Initialize the page cache for program text */
+    page_cache_init();
+
+    /* Size the process table from the memory that is left */
+    tracef("room for %u processes\n", process_table_init());
+    pipe_init();
+    timer_init();
+    profile_init();
+    console_scrollback_init();
+
     /* Enable interrupts */
     /* Do not enable the following until after you have set up your
      * IDT correctly otherwise QEMU will triple fault and simple close
@@ -180,23 +207,9 @@ void entry(unsigned long magic, unsigned long addr) {
     sti();
     video_mem = (char *)VIDEO;
 	int32_t j;
-	int32_t shade;
-    int32_t lol;
-	for (j = 0; j < NUM_COLS*NUM_ROWS; j++) {
-	    lol = 1*FOUR_KB;
-	    shade = BLACK + (WHITE << BACKGROUND); //allows a white background with a black text
-		*(uint8_t *)(video_mem + lol + (j << 1)) = ' ';
-		*(uint8_t *)(video_mem + lol + (j << 1) + 1) = shade;
-		
-		lol = 2*FOUR_KB;
-        shade = LIGHT_RED + (DARK_GRAY << BACKGROUND); //allows a dark_gray background with a light_red text
-        *(uint8_t *)(video_mem + lol + (j << 1)) = ' ';
-		*(uint8_t *)(video_mem + lol + (j << 1) + 1) = shade;
-	
-		lol = 3*FOUR_KB;
-		shade = LIGHT_GREEN + (LIGHT_BLUE << BACKGROUND); //allows a light_blue background with a light_green text
-		*(uint8_t *)(video_mem + lol + (j << 1)) = ' ';
-		*(uint8_t *)(video_mem + lol + (j << 1) + 1) = shade;
+	for (j = 1; j < MAX_TERMINALS; j++) {
+	    console_clear(j, terminal_colors[j]); //each hidden terminal starts blank in its own colours
+	    console_flush(j);
 	}
     sscreeny[0] = 0;
     sscreeny[1] = 0;
@@ -249,7 +262,7 @@ void entry(unsigned long magic, unsigned long addr) {
 	    rtc_write(0,&rate,4);
     }
     
-	rtc_disable_irq();
+	rtc_close(0); // the splash's clock was the only one, so the RTC stops too
     TERMINAL_FLAG = 1;
 	CURSOR = 1; //allows CURSOR flag to be changed
     
@@ -259,15 +272,12 @@ void entry(unsigned long magic, unsigned long addr) {
 #ifdef RUN_TESTS
     /* Run tests */
     //launch_tests();
+    launch_boot_tests();
 #endif
     
-    cur_scheduled_terminal = 0xFF;
-    /* Execute the first program ("shell") ... */
-	/* Initialize pit */
+    /* Initialize pit, its first ticks start the shell of each terminal */
     pit_init();
-	
-	const char* cmd = "shell";
-	execute((uint8_t*)(cmd));
-    /* Spin (nicely, so we don't chew up cycles) */
-    asm volatile (".1: hlt; jmp .1;");
+
+    /* Become the idle loop (nicely, so we don't chew up cycles) */
+    scheduler_idle();
 }
@@ -2,6 +2,10 @@
 #include "types.h"
 #include "terminal.h"
 #include "multi_term.h"
+#include "signal.h"
+#include "config.h"
+#include "profile.h"
+#include "console.h"
 
 //a global array of chars that convert the scanline into a printable char. A capital X implies
 //a keypress that can't be represented easily on screen ie. backspace. 64 is the number of keys
@@ -47,6 +51,7 @@ void keyboard_init() {
     CTRL = 0; //intializes the CTRL boolean to zero
     TERMINATE = 0; //initialzes the TERMINATE boolean to zero
     ALT = 0;
+    EXTENDED = 0;
     cur_keyboard = keyboard_buf_0;
     return;
 }
@@ -59,15 +64,22 @@ void keyboard_init() {
 */
 uint8_t keyboard_get_scanline() {
     uint8_t result = inb(DATA_PORT); //obtains the scanline from the Keyboard portion
-    if (result == CONTROL) {CTRL = 1; leave();}
+    uint8_t extended = EXTENDED; //whether this scanline is for an extended key
+    EXTENDED = (result == EXTENDED_PREFIX);
+    if (result == EXTENDED_PREFIX) {leave();}
+    else if (extended && (result == LEFT_SHIFT_PRESS || result == LEFT_SHIFT_DEPRESS)) {leave();} //shift the keyboard fakes around an extended key, the real one is still held
+    else if (result == CONTROL) {CTRL = 1; leave();}
     //implement tab and alt
     else if (CTRL && result == l_scanline) {clear_all();leave();} //clears screen and resets cursor if left control pressed
-    else if (CTRL && result == c_scanline) {leave(); halt(0);} //restarts shell is control c is pressed
+    else if (CTRL && result == c_scanline) {leave(); signal_foreground(cur_terminal, SIGNAL_INTERRUPT);} //interrupts the program in front of the shown terminal
+    else if (CTRL && result == p_scanline) {leave(); if (profile_running()) {profile_dump(); profile_stop();} else {profile_start();}} //starts the profiler, or stops it and sends the samples over COM1
     else if (result == CONTROL_DEPRESS) {CTRL = 0; leave();} 
     else if (result == CAPS_LOCK) {CAPS ^= 1; leave();} //reversed the caps boolean based of how many times caps is pressed
     else if (result == LEFT_SHIFT_PRESS || result == RIGHT_SHIFT_PRESS) {SHIFT = 1; leave();} //sets shift on is pressed
     else if (result == LEFT_SHIFT_DEPRESS || result == RIGHT_SHIFT_DEPRESS) {SHIFT = 0; leave();} //sets shift off when depressed
     else if (ALT && (result == F1 || result == F2 || result == F3)) {leave(); swap_terminal(result - F1);}
+    else if (SHIFT && result == PAGE_UP) {leave(); console_view(cur_terminal, CONSOLE_PAGE_ROWS);} //scrolls the shown terminal back a page through its history
+    else if (SHIFT && result == PAGE_DOWN) {leave(); console_view(cur_terminal, -CONSOLE_PAGE_ROWS);} //and forward again towards the live screen
     else if (result == F5) { leave(); scheduler(); }
     else if (result == LEFT_ALT_PRESS) { ALT = 1; leave(); }
     else if (result == LEFT_ALT_DEPRESS) { ALT = 0; leave(); }
@@ -82,7 +94,7 @@ uint8_t keyboard_get_scanline() {
 	    }
     } // moves cursor back by one, puts a space, and moves curosr back by one to simulate a backspace. -1 is the offset to move x position back by one
     //else if (result == TAB && buf_index[cur_terminal] > TAB_LIMIT) {leave();}
-    else if (result != BACKSPACE && (buf_index[cur_terminal] == KEYBOARD_LIMIT && (result != ENTER_PRESS))) {leave();}
+    else if (result != BACKSPACE && (buf_index[cur_terminal] >= kernel_config.line_limit && (result != ENTER_PRESS))) {leave();}
     else if (result >= KEY_PASS) {leave();}
     return result;
 }
@@ -124,6 +136,7 @@ void keyboard_interrupt_handle() {
 	//} 
 	
 	//while (tab_loop != 0) { //runs until tab_loop is 0 to simulate a counter
+        console_live(cur_terminal); //typing goes back to the live screen from the history
         line_buffered_input(key); //places key onto screen and places it onto buffer
 	            putc_shell(key);
                 //putc(key);
@@ -133,6 +146,7 @@ void keyboard_interrupt_handle() {
         if (key == '\n') {
 	    //ENTER = 1; //sets ENTER flag to 1 to indicate that ENTER is pressed
 	    enter[cur_terminal] = 1;
+	    wait_queue_wake_all(&enter_queue[cur_terminal]); //lets a blocked terminal_read run
 	//    buf_index_copy[cur_terminal] = buf_index[cur_terminal]; //copies buf_index over to copy
 	    buf_index[cur_terminal] = 0; //sets the buf_index to zero to restart buffer
 	}
@@ -45,10 +45,14 @@
 #define F_THREE     0x3D
 #define l_scanline 0x26
 #define c_scanline 0x2E
+#define p_scanline 0x19
 #define F1 0x3B
 #define F2 0x3C
 #define F3 0x3D
 #define F5 0x3F
+#define PAGE_UP 0x49
+#define PAGE_DOWN 0x51
+#define EXTENDED_PREFIX 0xE0 //comes before the scanline of the keys added after the first keyboards
 
 #define TAB_LIMIT 123
 #define KEYBOARD_LIMIT 127
@@ -74,6 +78,7 @@ uint8_t CTRL; //a boolean for if control is pressed
 uint8_t ENTER;
 uint8_t TERMINATE;
 uint8_t ALT;
+uint8_t EXTENDED; //a boolean for if the last byte was EXTENDED_PREFIX
 extern void keyboard_init(); //initializes the keyboard
 
 uint8_t keyboard_get_scanline(); //gets the scanline of the keyboard
@@ -3,6 +3,7 @@
  */
 
 #include "lib.h"
+#include "console.h"
 
 #define CURSOR_CONTROL 0x3D4
 #define CURSOR_DATA 0x3D5
@@ -66,10 +67,9 @@ void text_colour(int8_t text, int8_t background) {
 * SIDE EFFECT : clears screen and sets cursor to 0,0
 */
 void clear_all() {
-    clear();
     sscreenx[cur_terminal] = 0;
     sscreeny[cur_terminal] = 0;
-    flashy_set(0);
+    clear();
 }
 
 /* void flashy_set(unint16_t position)i
@@ -109,26 +109,16 @@ uint16_t get_flashy() {
  * SIDE EFFECTS: scrolls screen
  */
 void vertical_scroll() {
-    memmove(video_mem + VIDEO_MEM_OFFSET, video_mem + VIDEO_MEM_OFFSET + VIDEO_SPACE_PER_ROW, TOTAL_VIDEO_SPACE);
-    int32_t j;
-	for(j = 0; j < NUM_COLS; j++){
-		*(uint8_t *)(video_mem + VIDEO_MEM_OFFSET + ((NUM_COLS*(NUM_ROWS - 1) + j) << 1)) = ' ';
-		*(uint8_t *)(video_mem + VIDEO_MEM_OFFSET + ((NUM_COLS*(NUM_ROWS - 1) + j) << 1) + 1) = ARRTIB;;
-	}
-
+    console_scroll(cur_scheduled_terminal, ARRTIB);
 }
 
 /* void clear(void);
  * Inputs: void
  * Return Value: none
- * Function: Clears video memory */
+ * Function: Clears the shown terminal */
 void clear(void) {
-    int32_t i;
-    for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
-        *(uint8_t *)(video_mem + (i << 1)) = ' ';
-        *(uint8_t *)(video_mem + (i << 1) + 1) = ATTRIB;
-    }
-    
+    console_clear(cur_terminal, ATTRIB);
+    console_flush(cur_terminal);
 }
 
 /* Standard printf().
@@ -254,6 +244,7 @@ format_char_switch:
         }
         buf++;
     }
+    console_flush(cur_scheduled_terminal);
     return (buf - format);
 }
 
@@ -269,6 +260,7 @@ int32_t puts(int8_t* s) {
         putc(s[index]);
         index++;
     }
+    console_flush(cur_scheduled_terminal);
     return index;
 }
 /* void putc_shell(uint8_t c);
@@ -287,8 +279,7 @@ void putc_shell(uint8_t c) {
 	else {sscreeny[cur_terminal]++;}
         sscreenx[cur_terminal] = 0;
     } else {
-        *(uint8_t *)(video_mem + ((NUM_COLS *sscreeny[cur_terminal] + sscreenx[cur_terminal]) << 1)) = c;
-        *(uint8_t *)(video_mem + ((NUM_COLS *sscreeny[cur_terminal] + sscreenx[cur_terminal]) << 1) + 1) = ATTRIB;
+        console_put(cur_terminal, sscreenx[cur_terminal], sscreeny[cur_terminal], c, ATTRIB);
         sscreenx[cur_terminal]++;
 	if (sscreenx[cur_terminal] == NUM_COLS) { //if screen_x hits end of row, place newline 
 	if (sscreeny[cur_terminal] == NUM_ROWS - 1) {vertical_scroll_shell();}
@@ -299,7 +290,8 @@ void putc_shell(uint8_t c) {
 	sscreenx[cur_terminal] %= NUM_COLS;
         sscreeny[cur_terminal] %= NUM_ROWS;	
     }
-    flashy_set(sscreenx[cur_terminal] + sscreeny[cur_terminal]*NUM_COLS); //sets cursor to next screen positio
+    consoles[cur_terminal].cursor_moved = 1; //sets cursor to next screen position
+    console_flush(cur_terminal); //echoed keys show up right away
 }
 
 /* void vertical_scroll_shell()
@@ -310,20 +302,14 @@ void putc_shell(uint8_t c) {
  * SIDE EFFECTS: scrolls screen
  */
 void vertical_scroll_shell() {
-    memmove(video_mem, video_mem + VIDEO_SPACE_PER_ROW, TOTAL_VIDEO_SPACE);
-    int32_t j;
-	for(j = 0; j < NUM_COLS; j++){
-		*(uint8_t *)(video_mem + ((NUM_COLS*(NUM_ROWS - 1) + j) << 1)) = ' ';
-		*(uint8_t *)(video_mem + ((NUM_COLS*(NUM_ROWS - 1) + j) << 1) + 1) = ATTRIB;;
-        }
-
-
+    console_scroll(cur_terminal, ATTRIB);
 }
 /* void putc(uint8_t c);
  * Inputs: uint_8* c = character to print
  * Return Value: void
  *  Function: Output a character to the console and calls vertical scroll at 
- *  end of screen as well as new line at end of row
+ *  end of screen as well as new line at end of row. The character only
+ *  reaches the screen on the next console_flush
  */
 void putc(uint8_t c) {
     if(c == '\n' || c == '\r') {
@@ -332,9 +318,7 @@ void putc(uint8_t c) {
         else {sscreeny[cur_scheduled_terminal]++;}
         sscreenx[cur_scheduled_terminal] = 0;
     } else {
-        *(uint8_t *)(video_mem + VIDEO_MEM_OFFSET + ((NUM_COLS *sscreeny[cur_scheduled_terminal] + sscreenx[cur_scheduled_terminal]) << 1)) = c;
-	if (TERMINAL_FLAG) {*(uint8_t *)(video_mem + VIDEO_MEM_OFFSET + ((NUM_COLS *sscreeny[cur_scheduled_terminal] + sscreenx[cur_scheduled_terminal]) << 1) + 1) = ARRTIB;}
-	else {*(uint8_t *)(video_mem + VIDEO_MEM_OFFSET + ((NUM_COLS *sscreeny[cur_scheduled_terminal] + sscreenx[cur_scheduled_terminal]) << 1) + 1) = ATTRIB;}
+        console_put(cur_scheduled_terminal, sscreenx[cur_scheduled_terminal], sscreeny[cur_scheduled_terminal], c, TERMINAL_FLAG ? ARRTIB : ATTRIB);
 
 	sscreenx[cur_scheduled_terminal]++;
 	if (sscreenx[cur_scheduled_terminal] == NUM_COLS) { //if screen_x hits end of row, emplace newline 
@@ -346,7 +330,7 @@ void putc(uint8_t c) {
     sscreenx[cur_scheduled_terminal] %= NUM_COLS;
     sscreeny[cur_scheduled_terminal] %= NUM_ROWS;
  
-    if (CURSOR)flashy_set(sscreenx[cur_scheduled_terminal] + sscreeny[cur_scheduled_terminal]*NUM_COLS); //sets cursor to next screen position
+    if (CURSOR) consoles[cur_scheduled_terminal].cursor_moved = 1; //cursor follows on the next flush
     
 }
 
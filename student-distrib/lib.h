@@ -17,8 +17,6 @@
 #define FOUR_KB              0x1000
 #define EIGHT_KB             0x2000
 #define ONE_TWENTY_EIGHT_MB  0x8000000
-#define TOTAL_VIDEO_SPACE    3840
-#define VIDEO_SPACE_PER_ROW  160
 #define VIDEO 0xB8000
 #define NUM_COLS 80
 #define NUM_ROWS 25
@@ -64,7 +62,6 @@ uint32_t strlen(const int8_t* s);
 void clear(void);
 int8_t ATTRIB;
 int8_t ARRTIB;
-int32_t VIDEO_MEM_OFFSET; 
 
 void* memset(void* s, int32_t c, uint32_t n);
 void* memset_word(void* s, int32_t c, uint32_t n);
@@ -130,6 +127,18 @@ static inline uint32_t inl(port) {
     return val;
 }
 
+/* Reads the low 32 bits of the time stamp counter. Only good for timing
+ * short stretches of code, the counter wraps every few seconds */
+static inline uint32_t rdtsc(void) {
+    uint32_t low;
+    asm volatile ("rdtsc"
+            : "=a"(low)
+            :
+            : "edx"
+    );
+    return low;
+}
+
 /* Writes a byte to a port */
 #define outb(data, port)                \
 do {                                    \
@@ -0,0 +1,174 @@
+#include "page_cache.h"
+#include "frame_alloc.h"
+
+// entries and the hash chains that index them by inode and page
+static page_cache_entry_t cache_entries[PAGE_CACHE_FRAMES];
+static int32_t cache_buckets[PAGE_CACHE_BUCKETS];
+
+// next entry the eviction scan looks at
+static uint32_t clock_hand = 0;
+
+// first frame of the cache, and how many frames it got
+static uint32_t cache_base = 0;
+static uint32_t cache_frames = 0;
+
+static uint32_t page_cache_hash(uint32_t inode, uint32_t page);
+static int32_t page_cache_find(uint32_t inode, uint32_t page);
+static int32_t page_cache_evict();
+
+/* page_cache_init
+ * DESCRIPTION: Takes the cache's frames from the frame allocator, empties
+ *              every hash bucket and marks every frame unused. Without
+ *              memory for it the cache has no frames and programs load
+ *              private copies of their pages
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Resets the page cache
+ */
+void page_cache_init() {
+    int i;
+    cache_base = frame_alloc(PAGE_CACHE_ORDER);
+    cache_frames = (cache_base != 0) ? PAGE_CACHE_FRAMES : 0;
+    for (i = 0; i < PAGE_CACHE_BUCKETS; i++) {
+        cache_buckets[i] = CACHE_NONE;
+    }
+    for (i = 0; i < PAGE_CACHE_FRAMES; i++) {
+        cache_entries[i].valid = 0;
+        cache_entries[i].refcount = 0;
+        cache_entries[i].next = CACHE_NONE;
+    }
+}
+
+/* page_cache_get
+ * DESCRIPTION: Finds the frame holding the given page of an executable. On
+ *              a miss an unreferenced frame is recycled and filled from the
+ *              file, with anything past the end of the file zeroed
+ * INPUTS: inode - executable
+ *         page - index of the 4KB page within the file
+ * OUTPUTS: physical address of the frame, or 0 if every frame is in use
+ * SIDE EFFECTS: Takes a reference on the frame
+ */
+uint32_t page_cache_get(uint32_t inode, uint32_t page) {
+    uint32_t frame = page_cache_lookup(inode, page);
+    if (frame != 0) { return frame; }
+
+    int32_t idx = page_cache_evict();
+    if (idx == CACHE_NONE) { return 0; }
+
+    frame = cache_base + (idx * FOUR_KB);
+    int32_t bytes = read_data(inode, page * FOUR_KB, (uint8_t*)frame, FOUR_KB);
+    if (bytes == FAILURE) { return 0; }
+    memset((uint8_t*)frame + bytes, 0, FOUR_KB - bytes);
+
+    // link the entry into its bucket
+    uint32_t bucket = page_cache_hash(inode, page);
+    cache_entries[idx].inode = inode;
+    cache_entries[idx].page = page;
+    cache_entries[idx].refcount = 1;
+    cache_entries[idx].valid = 1;
+    cache_entries[idx].next = cache_buckets[bucket];
+    cache_buckets[bucket] = idx;
+    return frame;
+}
+
+/* page_cache_lookup
+ * DESCRIPTION: Finds the frame holding the given page of an executable
+ * INPUTS: inode - executable
+ *         page - index of the 4KB page within the file
+ * OUTPUTS: physical address of the frame, or 0 if it isn't cached
+ * SIDE EFFECTS: Takes a reference on the frame when found
+ */
+uint32_t page_cache_lookup(uint32_t inode, uint32_t page) {
+    int32_t idx = page_cache_find(inode, page);
+    if (idx == CACHE_NONE) { return 0; }
+    cache_entries[idx].refcount++;
+    return cache_base + (idx * FOUR_KB);
+}
+
+/* page_cache_put
+ * DESCRIPTION: Drops a reference on a cached frame. Frames with no
+ *              references keep their contents until they are recycled, so
+ *              the next execute of the same program still finds them
+ * INPUTS: frame - physical address returned by page_cache_get/lookup
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Decrements the frame's reference count
+ */
+void page_cache_put(uint32_t frame) {
+    uint32_t idx = (frame - cache_base) / FOUR_KB;
+    if (frame < cache_base || idx >= cache_frames) { return; }
+    if (cache_entries[idx].refcount > 0) { cache_entries[idx].refcount--; }
+}
+
+/* page_cache_dup
+ * DESCRIPTION: Takes another reference on a frame that is already mapped,
+ *              for fork handing the mapping to the child too
+ * INPUTS: frame - physical address returned by page_cache_get/lookup
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Increments the frame's reference count
+ */
+void page_cache_dup(uint32_t frame) {
+    uint32_t idx = (frame - cache_base) / FOUR_KB;
+    if (frame < cache_base || idx >= cache_frames) { return; }
+    cache_entries[idx].refcount++;
+}
+
+/* page_cache_owns
+ * DESCRIPTION: Tells page cache frames apart from other frames
+ * INPUTS: frame - physical address of a frame
+ * OUTPUTS: 1 if the frame belongs to the cache, 0 otherwise
+ * SIDE EFFECTS: NONE
+ */
+int32_t page_cache_owns(uint32_t frame) {
+    return frame >= cache_base && (frame - cache_base) / FOUR_KB < cache_frames;
+}
+
+/* page_cache_hash
+ * DESCRIPTION: Picks the bucket of a page
+ * INPUTS: inode, page - key of the page
+ * OUTPUTS: bucket index
+ * SIDE EFFECTS: NONE
+ */
+static uint32_t page_cache_hash(uint32_t inode, uint32_t page) {
+    return ((inode * FNV_PRIME) ^ page) & PAGE_CACHE_MASK;
+}
+
+/* page_cache_find
+ * DESCRIPTION: Walks the bucket of a page looking for it
+ * INPUTS: inode, page - key of the page
+ * OUTPUTS: entry index or CACHE_NONE
+ * SIDE EFFECTS: NONE
+ */
+static int32_t page_cache_find(uint32_t inode, uint32_t page) {
+    int32_t idx = cache_buckets[page_cache_hash(inode, page)];
+    while (idx != CACHE_NONE) {
+        if (cache_entries[idx].inode == inode && cache_entries[idx].page == page) { return idx; }
+        idx = cache_entries[idx].next;
+    }
+    return CACHE_NONE;
+}
+
+/* page_cache_evict
+ * DESCRIPTION: Goes around the frames from the clock hand looking for one
+ *              that is unused or holds a page nobody maps, and unhooks it
+ * INPUTS: NONE
+ * OUTPUTS: entry index of a free frame, or CACHE_NONE if all are mapped
+ * SIDE EFFECTS: Forgets the page that used to be in the frame
+ */
+static int32_t page_cache_evict() {
+    uint32_t i;
+    for (i = 0; i < cache_frames; i++) {
+        int32_t idx = clock_hand;
+        clock_hand = (clock_hand + 1) % cache_frames;
+        if (!cache_entries[idx].valid) { return idx; }
+        if (cache_entries[idx].refcount != 0) { continue; }
+
+        // unlink from its bucket
+        int32_t* link = &(cache_buckets[page_cache_hash(cache_entries[idx].inode, cache_entries[idx].page)]);
+        while (*link != idx) { link = &(cache_entries[*link].next); }
+        *link = cache_entries[idx].next;
+        cache_entries[idx].valid = 0;
+        cache_entries[idx].next = CACHE_NONE;
+        return idx;
+    }
+    return CACHE_NONE;
+}
@@ -0,0 +1,45 @@
+#ifndef _PAGE_CACHE_H
+#define _PAGE_CACHE_H
+
+#include "types.h"
+#include "lib.h"
+#include "paging.h"
+#include "filesys.h"
+#include "syscall.h"
+
+// Frames holding executable pages come from one 4MB block of the frame
+// allocator, reached by the kernel through the direct map
+#define PAGE_CACHE_ORDER    10
+#define PAGE_CACHE_FRAMES   (1 << PAGE_CACHE_ORDER)
+#define PAGE_CACHE_BUCKETS  256
+#define PAGE_CACHE_MASK     (PAGE_CACHE_BUCKETS - 1)
+#define CACHE_NONE          -1
+
+// One cached page of an executable. Entry i owns the i'th frame of the cache
+typedef struct page_cache_entry {
+    uint32_t inode;     // executable the page belongs to
+    uint32_t page;      // index of the 4KB page within the file
+    uint32_t refcount;  // number of program page tables mapping the frame
+    int32_t next;       // next entry in the same hash bucket
+    uint8_t valid;      // entry holds a page
+} page_cache_entry_t;
+
+// Sets up the cache, all frames start out free. Needs the frame allocator
+extern void page_cache_init();
+
+// Returns the frame holding a page of a file, loading it if needed
+extern uint32_t page_cache_get(uint32_t inode, uint32_t page);
+
+// Returns the frame holding a page of a file only if it is already loaded
+extern uint32_t page_cache_lookup(uint32_t inode, uint32_t page);
+
+// Drops a reference taken by page_cache_get or page_cache_lookup
+extern void page_cache_put(uint32_t frame);
+
+// Takes another reference on a frame that is already referenced
+extern void page_cache_dup(uint32_t frame);
+
+// Returns 1 if the frame is one of the cache's
+extern int32_t page_cache_owns(uint32_t frame);
+
+#endif
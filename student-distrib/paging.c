@@ -2,6 +2,9 @@
 #include "types.h"
 #include "x86_desc.h"
 #include "syscall.h"
+#include "page_cache.h"
+#include "exception.h"
+#include "frame_alloc.h"
 
 // array for page directory entries
 static unsigned long page_directory_entries[NUM_OF_ENTRIES] __attribute__((aligned(TOTAL_SIZE)));
@@ -11,14 +14,18 @@ static unsigned long page_table_entries[NUM_OF_ENTRIES] __attribute__((aligned(T
 
 static unsigned long video_mem_page_table[NUM_OF_ENTRIES] __attribute__((aligned(TOTAL_SIZE)));
 
+static void release_user_frame(uint32_t frame);
+
 /* 
    FUNCTION:    paging_init()
    DESCRIPTION: This function turns on paging and ensures that kernel continues
                 to work. First, all entries are marked as non-present in both
                 the page directory and table. Then, entries for the kernel and 
                 video memory are created in both and pages are marked as 
-                present. Finally, assembly code is used to correctly set 
-                registers cr0, cr3, and cr4 in order to actually enable paging.
+                present, along with a direct map of the frame allocator's
+                memory. Finally, assembly code is used to correctly set 
+                registers cr0, cr3, and cr4 in order to actually enable 
+                paging.
    INPUTS:      None
    OUTPUTS:     None 
 */
@@ -44,28 +51,36 @@ void paging_init() {
 
     // add page table entry for video memory
     // pages are present and can be read and written-into
-    page_table_entries[((VIDEO_MEMORY) >> TABLE_INDEX_SHIFT)] = (VIDEO_MEMORY) | (FLAG_P) | (FLAG_RW);
-    
-    // Add video memory bakup pages for multiple terminals
-    page_table_entries[VMEM_BAK_ONE_IDX] = VMEM_BAK_ONE_ADDR | FLAG_P | FLAG_RW | FLAG_US;
-    page_table_entries[VMEM_BAK_TWO_IDX] = VMEM_BAK_TWO_ADDR | FLAG_P | FLAG_RW | FLAG_US;
-    page_table_entries[VMEM_BAK_THREE_IDX] = VMEM_BAK_THREE_ADDR | FLAG_P | FLAG_RW | FLAG_US;
+    // video pages are the same in every process, so they are global
+    page_table_entries[((VIDEO_MEMORY) >> TABLE_INDEX_SHIFT)] = (VIDEO_MEMORY) | (FLAG_P) | (FLAG_RW) | (FLAG_G);
 
+    // the rest of video memory, where every terminal keeps its screen even
+    // while it isn't shown, kernel only
+    for(i = VGA_REST_START_IDX; i < VGA_REST_END_IDX; i++) {
+        page_table_entries[i] = (i * TOTAL_SIZE) | (FLAG_P) | (FLAG_RW) | (FLAG_G);
+    }
 
 
     // add second page directory entry for kernel
-    // pages are present, size is 4MB, and can be read and written-into
-    page_directory_entries[1] = (KERNEL_ADDRESS) | (FLAG_P) | (FLAG_RW) | (FLAG_PS);
+    // pages are present, size is 4MB, can be read and written-into, and
+    // survive cr3 loads
+    page_directory_entries[1] = (KERNEL_ADDRESS) | (FLAG_P) | (FLAG_RW) | (FLAG_PS) | (FLAG_G);
+
+    // direct map of the memory the frame allocator hands out, kernel only,
+    // so frames can be filled and page tables edited at their own address
+    for(i = DIRECT_MAP_START_IDX; i < DIRECT_MAP_END_IDX; i++) {
+        page_directory_entries[i] = (i * FOUR_MB) | (FLAG_P) | (FLAG_RW) | (FLAG_PS) | (FLAG_G);
+    }
 
     // assembly language to turn on paging
     asm volatile (   
         "movl   %0, %%eax;"                      // eax <- 0
         "movl   %%eax, %%cr3;"                   // cr3 <- eax    
         "movl   %%cr4, %%eax;"                   // eax <- cr4
-        "orl    $0x00000010, %%eax;"             // OR eax with 0x00000010
+        "orl    $0x00000090, %%eax;"             // OR eax with 0x00000090 (PGE, PSE)
         "movl   %%eax, %%cr4;"                   // cr4 <- eax
         "movl   %%cr0, %%eax;"                   // eax <- cr0
-        "orl    $0x80000001, %%eax;"             // OR eax with 0x80000001
+        "orl    $0x80010001, %%eax;"             // OR eax with 0x80010001 (PG, WP, PE)
         "movl   %%eax, %%cr0;"                   // cr0 <- eax
         :
         : "r"(page_directory_entries)            // page directory input
@@ -99,3 +114,267 @@ uint32_t* get_table_entry(uint32_t table_idx) {
 uint32_t* get_vidmem_entry(uint32_t table_idx) {
     return (uint32_t*)&(video_mem_page_table[table_idx]);
 }
+
+/* get_mmap_table
+ * INPUTS: process_id - process whose mmap table is requested
+ * RETURNS: pointer to the first entry of the table
+ * SIDE EFFECTS: None
+ */
+uint32_t* get_mmap_table(uint32_t process_id) {
+    return get_pcb(process_id)->mmap_table;
+}
+
+/* get_program_table
+ * INPUTS: process_id - process whose program table is requested
+ * RETURNS: pointer to the first entry of the table
+ * SIDE EFFECTS: None
+ */
+uint32_t* get_program_table(uint32_t process_id) {
+    return get_pcb(process_id)->program_table;
+}
+
+/* get_process_directory
+ * INPUTS: process_id - process whose page directory is requested
+ * RETURNS: pointer to the first entry of the directory
+ * SIDE EFFECTS: None
+ */
+uint32_t* get_process_directory(uint32_t process_id) {
+    return get_pcb(process_id)->page_directory;
+}
+
+/* paging_alloc_process
+ * DESCRIPTION: Allocates a page directory, a program table and an mmap
+ *              table for a new pcb. The directory is a copy of the kernel's
+ *              with the two tables plugged in
+ * INPUTS: pcb - process being created
+ * RETURNS: SUCCESS, or FAILURE when out of frames
+ * SIDE EFFECTS: Sets the paging fields of the pcb
+ */
+int32_t paging_alloc_process(pcb_t* pcb) {
+    uint32_t* directory = (uint32_t*)frame_alloc(0);
+    uint32_t* program = (uint32_t*)frame_alloc(0);
+    uint32_t* mmap = (uint32_t*)frame_alloc(0);
+    if (directory == NULL || program == NULL || mmap == NULL) {
+        if (directory != NULL) { frame_free((uint32_t)directory, 0); }
+        if (program != NULL) { frame_free((uint32_t)program, 0); }
+        if (mmap != NULL) { frame_free((uint32_t)mmap, 0); }
+        return FAILURE;
+    }
+
+    memcpy(directory, page_directory_entries, TOTAL_SIZE);
+    memset(program, 0, TOTAL_SIZE);
+    memset(mmap, 0, TOTAL_SIZE);
+    directory[PROG_PAGE_IDX] = ((uint32_t)program) | FLAG_P | FLAG_RW | FLAG_US;
+    directory[MMAP_DIR_IDX] = ((uint32_t)mmap) | FLAG_P | FLAG_RW | FLAG_US;
+    pcb->page_directory = directory;
+    pcb->program_table = program;
+    pcb->mmap_table = mmap;
+    return SUCCESS;
+}
+
+/* paging_free_process
+ * DESCRIPTION: Frees a process' pages and its paging structures
+ * INPUTS: pcb - process being destroyed, not the one running
+ * RETURNS: None
+ * SIDE EFFECTS: Frees frames
+ */
+void paging_free_process(pcb_t* pcb) {
+    reset_process_pages(pcb->process_id);
+    frame_free((uint32_t)pcb->page_directory, 0);
+    frame_free((uint32_t)pcb->program_table, 0);
+    frame_free((uint32_t)pcb->mmap_table, 0);
+}
+
+/* map_process_pages
+ * DESCRIPTION: Loads the page directory of the given process. This flushes
+ *              the process' own translations, the kernel and video pages
+ *              are global and stay in the TLB
+ * INPUTS: process_id - process that is about to run
+ * RETURNS: None
+ * SIDE EFFECTS: Changes cr3
+ */
+void map_process_pages(uint32_t process_id) {
+    asm volatile (
+        "movl %0, %%cr3;"
+        :
+        : "r"(get_pcb(process_id)->page_directory)
+        : "memory"
+    );
+}
+
+/* map_kernel_pages
+ * DESCRIPTION: Loads the kernel page directory, which has no process memory
+ * INPUTS: None
+ * RETURNS: None
+ * SIDE EFFECTS: Changes cr3
+ */
+void map_kernel_pages() {
+    asm volatile (
+        "movl %0, %%cr3;"
+        :
+        : "r"(page_directory_entries)
+        : "memory"
+    );
+}
+
+/* reset_process_pages
+ * DESCRIPTION: Marks every page of a process' program image and mmap region
+ *              non-present, so a newly executed program starts out empty,
+ *              freeing its private frames and dropping the references held
+ *              on shared pages
+ * INPUTS: process_id - process being set up
+ * RETURNS: None
+ * SIDE EFFECTS: Clears the process' program and mmap page tables
+ */
+void reset_process_pages(uint32_t process_id) {
+    int i;
+    uint32_t* program = get_program_table(process_id);
+    for (i = 0; i < NUM_OF_ENTRIES; i++) {
+        if (program[i] & FLAG_P) { release_user_frame(program[i] & PAGE_ADDR_MASK); }
+    }
+    // mmap pages belong to the file system image, so nothing is freed
+    memset(program, 0, TOTAL_SIZE);
+    memset(get_mmap_table(process_id), 0, TOTAL_SIZE);
+}
+
+/* copy_process_pages
+ * DESCRIPTION: Gives a forked child the parent's address space without
+ *              copying anything. Every present program page is made
+ *              read-only and copy-on-write in both processes, and whoever
+ *              writes to it first gets a copy. The mmap region is read-only
+ *              file data, so its entries are copied as they are
+ * INPUTS: from_id - process calling fork
+ *         to_id - child, whose program table must be empty
+ * RETURNS: None
+ * SIDE EFFECTS: Takes a reference on every shared frame, flushes the
+ *               parent's translations if it is the one running
+ */
+void copy_process_pages(uint32_t from_id, uint32_t to_id) {
+    int i;
+    uint32_t* from = get_program_table(from_id);
+    uint32_t* to = get_program_table(to_id);
+    for (i = 0; i < NUM_OF_ENTRIES; i++) {
+        if (!(from[i] & FLAG_P)) { continue; }
+        uint32_t frame = from[i] & PAGE_ADDR_MASK;
+        if (page_cache_owns(frame)) { page_cache_dup(frame); }
+        else { frame_get(frame); }
+        from[i] = (from[i] & ~FLAG_RW) | FLAG_COW;
+        to[i] = from[i];
+    }
+    memcpy(get_mmap_table(to_id), get_mmap_table(from_id), TOTAL_SIZE);
+    get_pcb(to_id)->mmap_pages = get_pcb(from_id)->mmap_pages;
+
+    if (find_pcb() == get_pcb(from_id)) { map_process_pages(from_id); }
+}
+
+/* share_program_text
+ * DESCRIPTION: Maps every page of an executable that is already in the page
+ *              cache into a process read-only, so another running (or
+ *              recently run) copy of the program hands over its pages
+ *              without any faults or copying
+ * INPUTS: process_id - process being set up
+ *         inode - executable the process runs
+ *         length - size of the executable in bytes
+ * RETURNS: None
+ * SIDE EFFECTS: Takes a page cache reference for every page it maps
+ */
+void share_program_text(uint32_t process_id, uint32_t inode, uint32_t length) {
+    uint32_t first_idx = (PROG_CODE_START - VIRT_PAGE_START) >> TABLE_INDEX_SHIFT;
+    uint32_t page;
+    for (page = 0; page * FOUR_KB < length && first_idx + page < NUM_OF_ENTRIES; page++) {
+        uint32_t frame = page_cache_lookup(inode, page);
+        if (frame != 0) {
+            get_program_table(process_id)[first_idx + page] = frame | FLAG_P | FLAG_US | FLAG_COW;
+        }
+    }
+}
+
+/* demand_page
+ * DESCRIPTION: Called from the page fault handler. If addr is in a page of
+ *              the current program that hasn't been touched yet, the page is
+ *              either mapped read-only from the page cache (when it holds
+ *              part of the executable) or backed with the process' own
+ *              physical memory and zeroed. A write to a shared page gives
+ *              the process a private copy of it instead
+ * INPUTS: addr - faulting linear address
+ *         error_code - error code the processor pushed for the fault
+ * RETURNS: SUCCESS if the page was fixed up, FAILURE for a real fault
+ * SIDE EFFECTS: Maps and fills one 4KB page
+ */
+int32_t demand_page(uint32_t addr, uint32_t error_code) {
+    pcb_t* pcb = find_pcb();
+    if (pcb == NULL || addr < VIRT_PAGE_START || addr >= VIRT_PAGE_START + PROGRAM_SIZE) { return FAILURE; }
+
+    uint32_t page_idx = (addr - VIRT_PAGE_START) >> TABLE_INDEX_SHIFT;
+    uint32_t* entry = &(pcb->program_table[page_idx]);
+    uint32_t page_start = VIRT_PAGE_START + (page_idx * FOUR_KB);
+    uint32_t page_mem;
+
+    if (*entry & FLAG_P) {
+        // only writes to shared pages are expected, anything else is a real fault
+        if (!(error_code & PF_WRITE) || !(*entry & FLAG_COW)) { return FAILURE; }
+        uint32_t shared = *entry & PAGE_ADDR_MASK;
+
+        // the other processes a forked page was shared with are gone, so
+        // the page can simply become writable again
+        if (!page_cache_owns(shared) && frame_ref_count(shared) == 1) {
+            *entry = shared | FLAG_P | FLAG_RW | FLAG_US;
+            asm volatile ("invlpg (%0)" : : "r"(page_start) : "memory");
+            return SUCCESS;
+        }
+        if ((page_mem = frame_alloc(0)) == 0) { return FAILURE; }
+        *entry = page_mem | FLAG_P | FLAG_RW | FLAG_US;
+        asm volatile ("invlpg (%0)" : : "r"(page_start) : "memory");
+
+        // the shared frame is still reachable through the kernel's mapping
+        memcpy((void*)page_start, (void*)shared, FOUR_KB);
+        release_user_frame(shared);
+        return SUCCESS;
+    }
+
+    // part of the page that overlaps the file image at PROG_CODE_START
+    uint32_t page_end = page_start + FOUR_KB;
+    uint32_t image_end = PROG_CODE_START + pcb->exe_length;
+    uint32_t copy_start = page_start > PROG_CODE_START ? page_start : PROG_CODE_START;
+    uint32_t copy_end = page_end < image_end ? page_end : image_end;
+
+    // PROG_CODE_START is page aligned, so file pages line up with these pages
+    if (copy_start < copy_end) {
+        uint32_t frame = page_cache_get(pcb->exe_inode, (page_start - PROG_CODE_START) / FOUR_KB);
+        if (frame != 0) {
+            *entry = frame | FLAG_P | FLAG_US | FLAG_COW;
+            return SUCCESS;
+        }
+    }
+
+    // entry goes from non-present to present, so there is nothing to flush
+    if ((page_mem = frame_alloc(0)) == 0) { return FAILURE; }
+    *entry = page_mem | FLAG_P | FLAG_RW | FLAG_US;
+    if (copy_start >= copy_end) {
+        memset((void*)page_start, 0, FOUR_KB);
+        return SUCCESS;
+    }
+
+    // page cache is full of mapped pages, so load a private copy
+    memset((void*)page_start, 0, copy_start - page_start);
+    if (read_data(pcb->exe_inode, copy_start - PROG_CODE_START, (uint8_t*)copy_start, copy_end - copy_start) == FAILURE) {
+        *entry = 0x00000000;
+        frame_free(page_mem, 0);
+        return FAILURE;
+    }
+    memset((void*)copy_end, 0, page_end - copy_end);
+    return SUCCESS;
+}
+
+/* release_user_frame
+ * DESCRIPTION: Drops a process' reference on a frame it maps, giving page
+ *              cache frames back to the cache and freeing other frames
+ *              once no process maps them
+ * INPUTS: frame - physical address of the frame
+ * RETURNS: None
+ * SIDE EFFECTS: May free the frame
+ */
+static void release_user_frame(uint32_t frame) {
+    if (page_cache_owns(frame)) { page_cache_put(frame); }
+    else { frame_put(frame); }
+}
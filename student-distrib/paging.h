@@ -16,14 +16,14 @@
 #define TABLE_INSIDE          4098
 #define INVALID_ADDR          0x0
 #define VIDMEM_DIR_IDX        33
+#define MMAP_DIR_IDX          34       // 4MB of read-only file mappings per process
+#define DIRECT_MAP_START_IDX  2        // kernel direct map of 8MB to 128MB
+#define DIRECT_MAP_END_IDX    32
 
-#define VMEM_BAK_ONE_IDX      0xB9
-#define VMEM_BAK_TWO_IDX      0xBA
-#define VMEM_BAK_THREE_IDX    0xBB
-
-#define VMEM_BAK_ONE_ADDR     0xB9000
-#define VMEM_BAK_TWO_ADDR     0xBA000
-#define VMEM_BAK_THREE_ADDR   0xBB000
+// video memory after the first page, 32KB in all, split between the
+// terminals' screens
+#define VGA_REST_START_IDX    0xB9
+#define VGA_REST_END_IDX      0xC0
 
 
 /* ------------------------------------------------------------------------- */
@@ -96,6 +96,24 @@
    CLEAR: Page is not global
 */
 #define FLAG_G   0x100
+
+/*
+   FLAG_COW (Copy-On-Write, one of the bits left to the OS)
+   SET:   Page is a read-only mapping of a frame shared with other
+          processes, either a page cache frame or a page fork left in both
+          the parent and the child. A write gives the process its own copy
+   CLEAR: Page is private to the process
+*/
+#define FLAG_COW 0x200
+
+#define PAGE_ADDR_MASK 0xFFFFF000 // frame address bits of an entry
+
+/*
+   CR4_PGE (Page Global Enable)
+   SET:   Entries marked FLAG_G stay in the TLB when CR3 is loaded
+   CLEAR: Loading CR3 flushes every TLB entry
+*/
+#define CR4_PGE  0x80
 /* ------------------------------------------------------------------------- */
 
 // function to intialize paging
@@ -112,4 +130,37 @@ extern uint32_t* get_table_entry(uint32_t table_idx);
 // video memory page
 extern uint32_t* get_vidmem_entry(uint32_t table_idx);
 
+// Returns a pointer to the mmap page table of the specified process
+extern uint32_t* get_mmap_table(uint32_t process_id);
+
+// Returns a pointer to the page directory of the specified process
+extern uint32_t* get_process_directory(uint32_t process_id);
+
+// Allocates and frees the page directory and tables of a pcb. pcb.h can
+// include this header before pcb_t is defined, so the struct is declared here
+struct pcb_t;
+extern int32_t paging_alloc_process(struct pcb_t* pcb);
+extern void paging_free_process(struct pcb_t* pcb);
+
+// Loads the page directory of a process, global kernel pages stay cached
+extern void map_process_pages(uint32_t process_id);
+
+// Loads the kernel's own page directory
+extern void map_kernel_pages();
+
+// Empties the program and mmap page tables of a process, releasing shared pages
+extern void reset_process_pages(uint32_t process_id);
+
+// Returns a pointer to the program page table of the specified process
+extern uint32_t* get_program_table(uint32_t process_id);
+
+// Shares a process' pages copy-on-write with a newly forked child
+extern void copy_process_pages(uint32_t from_id, uint32_t to_id);
+
+// Maps the already cached pages of an executable into a process
+extern void share_program_text(uint32_t process_id, uint32_t inode, uint32_t length);
+
+// Loads or copies the page of the current program containing addr
+extern int32_t demand_page(uint32_t addr, uint32_t error_code);
+
 #endif 
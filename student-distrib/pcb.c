@@ -1,9 +1,26 @@
 
 #include "pcb.h"
+#include "scheduler.h"
+#include "frame_alloc.h"
+#include "slab.h"
+#include "config.h"
 
 // Address of current PCB
 pcb_t* curr_addr = NULL;
 
+// Number of process numbers the table was sized for at boot
+uint32_t max_processes = 0;
+
+// PCB of each process number, NULL until first used
+static pcb_t** process_pcbs = NULL;
+
+// One bit per process number, set while a running process holds it
+static uint32_t* pid_bitmap = NULL;
+
+// Slab caches for pcbs and their file descriptor tables
+static kmem_cache_t pcb_cache;
+static kmem_cache_t fd_table_cache;
+
 int32_t (*stdin_operations_table[NUM_OF_OPERATIONS])()={terminal_read, terminal_fail, terminal_open, terminal_close};
 int32_t (*stdout_operations_table[NUM_OF_OPERATIONS])()={terminal_fail, terminal_write, terminal_open, terminal_close};
 
@@ -18,6 +35,173 @@ pcb_t* find_pcb() {
     return curr_addr;
 }
 
+/*
+FUNCTION NAME: process_table_init
+DESCRIPTION:   sizes the process table from the frames left after the
+               kernel's own allocations, one process for every
+               PROCESS_MIN_FRAMES frames up to PID_LIMIT or the procs= boot
+               limit, and allocates the pcb pointers and pid bitmap in one
+               block
+INPUTS:        none
+OUTPUTS:       number of processes the table holds, 0 if out of memory
+SIDE EFFECTS:  allocates frames, sets max_processes
+*/
+uint32_t process_table_init() {
+    uint32_t words, bytes, order, i;
+    kmem_cache_init(&pcb_cache, "pcb", sizeof(pcb_t));
+    kmem_cache_init(&fd_table_cache, "fd_table", MAX_NUM_OF_FILES * sizeof(fentry_t));
+    max_processes = frame_free_count() / PROCESS_MIN_FRAMES;
+    if(max_processes > PID_LIMIT) { max_processes = PID_LIMIT; }
+    if(kernel_config.max_processes != 0 && max_processes > kernel_config.max_processes) {
+        max_processes = kernel_config.max_processes;
+    }
+
+    words = (max_processes + PID_WORD_BITS - 1) / PID_WORD_BITS;
+    bytes = max_processes * sizeof(pcb_t*) + words * sizeof(uint32_t);
+    for(order = 0; (FRAME_SIZE << order) < bytes; order++);
+    process_pcbs = (pcb_t**)frame_alloc(order);
+    if(process_pcbs == NULL) {
+        max_processes = 0;
+        return 0;
+    }
+    pid_bitmap = (uint32_t*)(process_pcbs + max_processes);
+    for(i = 0; i < max_processes; i++) { process_pcbs[i] = NULL; }
+
+    // bits past the last process number stay set so they are never handed out
+    for(i = 0; i < words; i++) { pid_bitmap[i] = 0; }
+    for(i = max_processes; i < words * PID_WORD_BITS; i++) {
+        pid_bitmap[i / PID_WORD_BITS] |= 1 << (i % PID_WORD_BITS);
+    }
+    return max_processes;
+}
+
+/*
+FUNCTION NAME: pid_first_free
+DESCRIPTION:   finds the lowest process number no process holds, skipping
+               full words of the bitmap and using bsf on the first one with
+               a clear bit
+INPUTS:        none
+OUTPUTS:       process number, FAILURE if the table is full
+SIDE EFFECTS:  none
+*/
+int32_t pid_first_free() {
+    uint32_t word, bit;
+    for(word = 0; word * PID_WORD_BITS < max_processes; word++) {
+        if(pid_bitmap[word] == PID_WORD_FULL) { continue; }
+        asm ("bsfl %1, %0" : "=r"(bit) : "r"(~pid_bitmap[word]));
+        return word * PID_WORD_BITS + bit;
+    }
+    return FAILURE;
+}
+
+/*
+FUNCTION NAME: pid_claim
+DESCRIPTION:   marks a process number as taken
+INPUTS:        process_number
+OUTPUTS:       none
+SIDE EFFECTS:  none
+*/
+void pid_claim(uint32_t process_number) {
+    if(process_number >= max_processes) { return; }
+    pid_bitmap[process_number / PID_WORD_BITS] |= 1 << (process_number % PID_WORD_BITS);
+}
+
+/*
+FUNCTION NAME: pid_release
+DESCRIPTION:   marks a process number as free again
+INPUTS:        process_number
+OUTPUTS:       none
+SIDE EFFECTS:  none
+*/
+void pid_release(uint32_t process_number) {
+    if(process_number >= max_processes) { return; }
+    pid_bitmap[process_number / PID_WORD_BITS] &= ~(1 << (process_number % PID_WORD_BITS));
+}
+
+/*
+FUNCTION NAME: pid_in_use
+DESCRIPTION:   checks whether a process holds a process number
+INPUTS:        process_number
+OUTPUTS:       1 if taken, 0 if free
+SIDE EFFECTS:  none
+*/
+int32_t pid_in_use(uint32_t process_number) {
+    if(process_number >= max_processes) { return 0; }
+    return (pid_bitmap[process_number / PID_WORD_BITS] >> (process_number % PID_WORD_BITS)) & 1;
+}
+
+/*
+FUNCTION NAME: get_pcb
+DESCRIPTION:   returns pcb address for a process number
+INPUTS:        process_number
+OUTPUTS:       pcb address
+SIDE EFFECTS:  none
+*/
+pcb_t* get_pcb(uint32_t process_number) {
+    if(process_number >= max_processes) { return NULL; }
+    return process_pcbs[process_number];
+}
+
+/*
+FUNCTION NAME: pcb_alloc
+DESCRIPTION:   makes sure a process number has a pcb, file descriptor table,
+               kernel stack and page tables, taking them from the slab caches
+               and frame allocator the first time. A number keeps them until
+               its parent frees it, so a shell restarting on its own stack
+               can get the same one back
+INPUTS:        process_number
+OUTPUTS:       pcb address, NULL if out of memory
+SIDE EFFECTS:  may allocate frames
+*/
+pcb_t* pcb_alloc(uint32_t process_number) {
+    if(process_number >= max_processes) { return NULL; }
+    if(process_pcbs[process_number] != NULL) { return process_pcbs[process_number]; }
+
+    pcb_t* pcb = (pcb_t*)kmem_cache_alloc(&pcb_cache);
+    if(pcb == NULL) { return NULL; }
+    pcb->process_id = process_number;
+    pcb->file_array = (fentry_t*)kmem_cache_alloc(&fd_table_cache);
+    pcb->kernel_stack = frame_alloc(KSTACK_ORDER);
+    if(pcb->file_array == NULL || pcb->kernel_stack == 0 || paging_alloc_process(pcb) == FAILURE) {
+        kmem_cache_free(pcb->file_array);
+        frame_free(pcb->kernel_stack, KSTACK_ORDER);
+        kmem_cache_free(pcb);
+        return NULL;
+    }
+    process_pcbs[process_number] = pcb;
+    return pcb;
+}
+
+/*
+FUNCTION NAME: pcb_free
+DESCRIPTION:   gives the pcb, file descriptor table, kernel stack and page
+               tables of a finished process back. Must not be called on the
+               stack being freed
+INPUTS:        process_number
+OUTPUTS:       none
+SIDE EFFECTS:  frees frames
+*/
+void pcb_free(uint32_t process_number) {
+    pcb_t* pcb = get_pcb(process_number);
+    if(pcb == NULL) { return; }
+    paging_free_process(pcb);
+    process_pcbs[process_number] = NULL;
+    frame_free(pcb->kernel_stack, KSTACK_ORDER);
+    kmem_cache_free(pcb->file_array);
+    kmem_cache_free(pcb);
+}
+
+/*
+FUNCTION NAME: pcb_stack_top
+DESCRIPTION:   returns the initial kernel esp of a process
+INPUTS:        pcb
+OUTPUTS:       top of the process' kernel stack block
+SIDE EFFECTS:  none
+*/
+uint32_t pcb_stack_top(pcb_t* pcb) {
+    return pcb->kernel_stack + PCB_MEM_SIZE - LONG;
+}
+
 /*
  * set_pcb
  * DESCRIPTION: Changes the current pcb
@@ -38,13 +222,13 @@ INPUTS:        command_str
 OUTPUTS:       pcb address
 SIDE EFFECTS:  creates pcb in kernel
 */
-pcb_t* pcb_init(uint8_t* command_str, uint8_t* arg,	uint8_t process_number){
+pcb_t* pcb_init(uint8_t* command_str, uint8_t* arg,	uint32_t process_number){
     
     int i;
-    if(process_number >= MAX_PROCESSES) { return NULL; }
     
     // Get the pointer for the new PCB
-    pcb_t* pcb = (pcb_t*)(PHYS_PAGE_START - ((process_number + 1) * PROG_STACK_SIZE));
+    pcb_t* pcb = pcb_alloc(process_number);
+    if(pcb == NULL) { return NULL; }
     pcb->parent_pcb = curr_addr;
     pcb->process_id = process_number;
     if (curr_addr != NULL) { curr_addr->child_pcb = pcb; }
@@ -53,13 +237,31 @@ pcb_t* pcb_init(uint8_t* command_str, uint8_t* arg,	uint8_t process_number){
     pcb->child_pcb = NULL;
     pcb->esp = 0x00000000;
     pcb->ebp = 0x00000000;
-    pcb->scheduler_ebp = 0x00000000;
+    pcb->context_esp = 0x00000000;
+    pcb->state = PROCESS_BLOCKED;
+    pcb->detached = 0;
+    pcb->owner = NULL;
+    pcb->exit_status = 0;
+    wait_queue_init(&pcb->child_exit);
+    for(i = START; i < NUM_SIGNALS; i++) { pcb->signal_handlers[i] = NULL; }
+    pcb->signals_pending = 0;
+    pcb->signals_masked = 0;
+    wait_queue_init(&pcb->sleep_queue);
+    pcb->terminal = (curr_addr != NULL) ? curr_addr->terminal : cur_scheduled_terminal;
+    pcb->wait_next = NULL;
+    pcb->wait_queue = NULL;
+    pcb->run_next = NULL;
+    pcb->run_prev = NULL;
+    pcb->mmap_pages = 0;
+    pcb->exe_inode = 0;
+    pcb->exe_length = 0;
 
     // Clear all PCB files
     for(i = START; i < MAX_FILES; i++){
         pcb->file_array[i].inode = NONE;
         pcb->file_array[i].file_position = START;
         pcb->file_array[i].flags = AVAILABLE;
+        pcb->file_array[i].object = NULL;
     }
 
     // initialize pcb files for stdin and stdout
@@ -85,15 +287,3 @@ void add_reg(uint32_t ebp, uint32_t esp) {
     curr_addr->ebp = ebp;
     curr_addr->esp = esp;
 }
-
-/*
- * save_scheduler_reg
- * DESCRIPTION: Saves the EBP for the scheduler
- * INPUTS:  ebp - The value of the ebp
- * OUTPUTS: NONE
- * SIDE EFFECTS: The previous value of scheduler_ebp gets overwritten
- */
-
-void save_scheduler_reg(uint32_t ebp) {
-    curr_addr->scheduler_ebp = ebp;
-}
@@ -3,12 +3,26 @@
 
 #include "types.h"
 #include "terminal.h"
+#include "wait_queue.h"
+#include "signal.h"
+#include "timer.h"
 
 // constants used for file array in pcb
 #define MIN_NUM_OF_FILES    2
 #define MAX_NUM_OF_FILES    8
 #define MAX_ARGS			128	
-#define MAX_PROCESSES		6
+#define KSTACK_ORDER		1	// kernel stacks are 8KB blocks of frames
+
+// process table constants, the table is sized at boot from free memory
+#define PID_LIMIT			1024	// vidmap gives each pid one page of a 4MB table
+#define PROCESS_MIN_FRAMES	8		// pcb block, paging structures and a few private pages
+#define PID_WORD_BITS		32
+#define PID_WORD_FULL		0xFFFFFFFF
+
+// scheduling states of a process
+#define PROCESS_BLOCKED		0	// waiting on a child or a wait channel
+#define PROCESS_RUNNABLE	1	// on the run queue
+#define PROCESS_ZOMBIE		2	// halted, its memory is freed once off its stack
 
 // structure for file entry
 typedef struct fentry {
@@ -16,25 +30,61 @@ typedef struct fentry {
 	int32_t inode;
 	int32_t file_position;
 	int32_t flags;
+	void* object;	// kernel object behind the descriptor, such as a pipe
 } fentry_t;
 
 // structure for process control block
 typedef struct pcb_t {
     uint8_t args[MAX_ARGS]; // command args
-    uint8_t process_id; // process number
+    uint32_t process_id; // process number
     uint32_t esp;       // esp and ebp for execute/halt
     uint32_t ebp;
-    uint32_t scheduler_ebp; // ebp for scheduler
+    uint32_t context_esp;   // kernel esp saved by switch_context
+    uint8_t state;          // PROCESS_BLOCKED, PROCESS_RUNNABLE or PROCESS_ZOMBIE
+    uint8_t terminal;       // terminal the process reads from and writes to
+    uint8_t detached;       // created by fork or spawn, no parent waits for it in execute
+    struct pcb_t* wait_next; // next process on the same wait queue
+    wait_queue_t* wait_queue; // queue the process sleeps on, NULL when it isn't
+    struct pcb_t* run_next; // neighbours on the run queue
+    struct pcb_t* run_prev;
     struct pcb_t* parent_pcb; // ptr to parent pcb
     struct pcb_t* child_pcb; // ptr to child
-    fentry_t file_array[MAX_NUM_OF_FILES]; // Files
+    struct pcb_t* owner;     // process that forked or spawned it, NULL once that one halts
+    wait_queue_t child_exit; // owner sleeps here in wait
+    uint32_t exit_status;    // status passed to halt, kept until the owner waits
+    void* signal_handlers[NUM_SIGNALS]; // user handler of each signal, NULL for the default action
+    uint32_t signals_pending; // one bit per signal raised but not delivered yet
+    uint32_t signals_masked;  // SIGNAL_ALL while a handler runs, until sigreturn
+    ktimer_t sleep_timer;     // wakes the process from sleep
+    wait_queue_t sleep_queue; // the process sleeps here alone
+    uint32_t mmap_pages; // pages used in the mmap region
+    uint32_t exe_inode;  // executable the program pages are loaded from
+    uint32_t exe_length;
+    uint32_t* page_directory; // paging structures, allocated with the pcb
+    uint32_t* program_table;
+    uint32_t* mmap_table;
+    uint32_t kernel_stack;  // base of the kernel stack block
+    fentry_t* file_array;   // MAX_NUM_OF_FILES entries from the fd table cache
 } pcb_t;
 
 // functions for pcb
 pcb_t* find_pcb();
+pcb_t* get_pcb(uint32_t process_number);
 void set_pcb(pcb_t* new_pcb);
-pcb_t* pcb_init(uint8_t* command_str, uint8_t* arg,	uint8_t process_number);
+pcb_t* pcb_alloc(uint32_t process_number);
+void pcb_free(uint32_t process_number);
+uint32_t pcb_stack_top(pcb_t* pcb);
+pcb_t* pcb_init(uint8_t* command_str, uint8_t* arg,	uint32_t process_number);
+
+// functions for the process table
+uint32_t process_table_init();
+int32_t pid_first_free();
+void pid_claim(uint32_t process_number);
+void pid_release(uint32_t process_number);
+int32_t pid_in_use(uint32_t process_number);
+
+// Number of process numbers the table was sized for at boot
+extern uint32_t max_processes;
 void add_reg(uint32_t ebp, uint32_t esp);
-void save_scheduler_reg(uint32_t ebp);
 
 #endif
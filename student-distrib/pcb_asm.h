@@ -1,6 +0,0 @@
-#ifndef _PCB_ASM_H
-#define _PCB_ASM_H
-
-void scheduler_save_reg();
-
-#endif
@@ -0,0 +1,210 @@
+#include "pipe.h"
+#include "slab.h"
+#include "frame_alloc.h"
+#include "syscall.h"
+
+// Every pipe_t comes from this cache, the rings are single frames
+static kmem_cache_t pipe_cache;
+
+// Operations tables for the two ends of a pipe
+int32_t (*pipe_read_operations_table[NUM_OF_OPERATIONS])() = {pipe_read, pipe_fail, pipe_open, pipe_close};
+int32_t (*pipe_write_operations_table[NUM_OF_OPERATIONS])() = {pipe_fail, pipe_write, pipe_open, pipe_close};
+
+static void pipe_open_end(fentry_t* file, pipe_t* ring, int32_t (*operations_table[NUM_OF_OPERATIONS])());
+
+/* pipe_init
+ * DESCRIPTION: Sets up the cache pipes are allocated from
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void pipe_init() {
+    kmem_cache_init(&pipe_cache, "pipe", sizeof(pipe_t));
+}
+
+/* pipe_create
+ * DESCRIPTION: Allocates a pipe and its ring and opens the read end in one
+ *              file entry and the write end in the other
+ * INPUTS: read_end - free file entry for the read end
+ *         write_end - free file entry for the write end
+ * OUTPUTS: SUCCESS, or FAILURE when out of memory
+ * SIDE EFFECTS: Fills in both file entries
+ */
+int32_t pipe_create(fentry_t* read_end, fentry_t* write_end) {
+    pipe_t* ring = (pipe_t*)kmem_cache_alloc(&pipe_cache);
+    if (ring == NULL) { return FAILURE; }
+    ring->buf = (uint8_t*)frame_alloc(0);
+    if (ring->buf == NULL) {
+        kmem_cache_free(ring);
+        return FAILURE;
+    }
+    ring->head = 0;
+    ring->count = 0;
+    ring->readers = 1;
+    ring->writers = 1;
+    wait_queue_init(&ring->readable);
+    wait_queue_init(&ring->writable);
+
+    pipe_open_end(read_end, ring, pipe_read_operations_table);
+    pipe_open_end(write_end, ring, pipe_write_operations_table);
+    return SUCCESS;
+}
+
+/* pipe_dup
+ * DESCRIPTION: Called on a file entry copied from another process. If it is
+ *              a pipe end the pipe gets another reader or writer, which
+ *              keeps it open until this copy is closed too
+ * INPUTS: file - copied file entry
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void pipe_dup(fentry_t* file) {
+    uint32_t flags;
+    pipe_t* ring = (pipe_t*)file->object;
+    if (file->flags != OCCUPIED || file->operations_table[CLOSE] != pipe_close) { return; }
+
+    cli_and_save(flags);
+    if (file->operations_table[READ] == pipe_read) { ring->readers++; }
+    else { ring->writers++; }
+    restore_flags(flags);
+}
+
+/* pipe_read
+ * DESCRIPTION: Sleeps until the pipe has data or every write end is
+ *              closed, then copies out as much as is waiting, up to nbytes
+ * INPUTS: fd - read end of a pipe
+ *         buf - where the bytes go
+ *         nbytes - most bytes to read
+ * OUTPUTS: bytes read, 0 once the pipe is empty with no writers left,
+ *          FAILURE if a signal came while it was empty
+ * SIDE EFFECTS: Wakes writers waiting for room
+ */
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes) {
+    uint32_t flags, length, first;
+    pipe_t* ring = (pipe_t*)find_pcb()->file_array[fd].object;
+    if (buf == NULL || nbytes < 0) { return FAILURE; }
+
+    cli_and_save(flags);
+    wait_event(&ring->readable, ring->count > 0 || ring->writers == 0);
+    if (ring->count == 0 && ring->writers != 0) {
+        // a signal cut the wait short
+        restore_flags(flags);
+        return FAILURE;
+    }
+    length = (ring->count < (uint32_t)nbytes) ? ring->count : (uint32_t)nbytes;
+
+    // the waiting bytes may wrap around the end of the ring
+    first = PIPE_SIZE - ring->head;
+    if (first > length) { first = length; }
+    memcpy(buf, ring->buf + ring->head, first);
+    memcpy((uint8_t*)buf + first, ring->buf, length - first);
+    ring->head = (ring->head + length) % PIPE_SIZE;
+    ring->count -= length;
+
+    if (length > 0) { wait_queue_wake_all(&ring->writable); }
+    restore_flags(flags);
+    return length;
+}
+
+/* pipe_write
+ * DESCRIPTION: Copies all nbytes into the pipe, sleeping whenever the ring
+ *              is full until a reader makes room
+ * INPUTS: fd - write end of a pipe
+ *         buf - bytes to write
+ *         nbytes - number of bytes
+ * OUTPUTS: bytes written, FAILURE if every read end is closed or a
+ *          signal comes before anything could be written
+ * SIDE EFFECTS: Wakes readers waiting for data
+ */
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes) {
+    uint32_t flags, length, tail, first;
+    uint32_t written = 0;
+    pipe_t* ring = (pipe_t*)find_pcb()->file_array[fd].object;
+    if (buf == NULL || nbytes < 0) { return FAILURE; }
+
+    cli_and_save(flags);
+    while (written < (uint32_t)nbytes) {
+        wait_event(&ring->writable, ring->count < PIPE_SIZE || ring->readers == 0);
+        if (ring->readers == 0 || ring->count == PIPE_SIZE) { break; }
+
+        length = PIPE_SIZE - ring->count;
+        if (length > nbytes - written) { length = nbytes - written; }
+        tail = (ring->head + ring->count) % PIPE_SIZE;
+        first = PIPE_SIZE - tail;
+        if (first > length) { first = length; }
+        memcpy(ring->buf + tail, (uint8_t*)buf + written, first);
+        memcpy(ring->buf, (uint8_t*)buf + written + first, length - first);
+        ring->count += length;
+        written += length;
+
+        wait_queue_wake_all(&ring->readable);
+    }
+    restore_flags(flags);
+    return (written == 0 && nbytes > 0) ? FAILURE : (int32_t)written;
+}
+
+/* pipe_open
+ * DESCRIPTION: Pipes have no name to open, they come from the pipe call
+ * INPUTS: filename - unused
+ * OUTPUTS: FAILURE
+ * SIDE EFFECTS: NONE
+ */
+int32_t pipe_open(const uint8_t* filename) {
+    return FAILURE;
+}
+
+/* pipe_close
+ * DESCRIPTION: Closes one end of a pipe. The other side is woken, so a
+ *              reader sees the end of the stream and a writer stops, and
+ *              the pipe is freed with its last descriptor
+ * INPUTS: fd - end of a pipe
+ * OUTPUTS: SUCCESS
+ * SIDE EFFECTS: May free the pipe
+ */
+int32_t pipe_close(int32_t fd) {
+    uint32_t flags;
+    fentry_t* file = &(find_pcb()->file_array[fd]);
+    pipe_t* ring = (pipe_t*)file->object;
+
+    cli_and_save(flags);
+    if (file->operations_table[READ] == pipe_read) { ring->readers--; }
+    else { ring->writers--; }
+    wait_queue_wake_all(&ring->readable);
+    wait_queue_wake_all(&ring->writable);
+    if (ring->readers == 0 && ring->writers == 0) {
+        frame_free((uint32_t)ring->buf, 0);
+        kmem_cache_free(ring);
+    }
+    file->object = NULL;
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* pipe_fail
+ * DESCRIPTION: Reading the write end or writing the read end
+ * INPUTS: fd, buf, nbytes - unused
+ * OUTPUTS: FAILURE
+ * SIDE EFFECTS: NONE
+ */
+int32_t pipe_fail(int32_t fd, const void* buf, int32_t nbytes) {
+    return FAILURE;
+}
+
+/* pipe_open_end
+ * DESCRIPTION: Fills in a file entry for one end of a pipe
+ * INPUTS: file - file entry to fill
+ *         ring - the pipe
+ *         operations_table - functions for that end
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void pipe_open_end(fentry_t* file, pipe_t* ring, int32_t (*operations_table[NUM_OF_OPERATIONS])()) {
+    int i;
+    for (i = START; i < NUM_OF_OPERATIONS; i++) {
+        file->operations_table[i] = operations_table[i];
+    }
+    file->inode = NONE;
+    file->file_position = START;
+    file->flags = OCCUPIED;
+    file->object = ring;
+}
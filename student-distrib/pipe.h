@@ -0,0 +1,43 @@
+#ifndef _PIPE_H
+#define _PIPE_H
+
+#include "types.h"
+#include "lib.h"
+#include "pcb.h"
+#include "wait_queue.h"
+
+#define PIPE_SIZE           FOUR_KB     // ring buffer is one frame
+
+/* testing constants */
+#define PIPE_BENCH_BYTES    (256*KILOBYTE)
+#define PIPE_BENCH_SMALL    64
+#define PIPE_BENCH_LARGE    PIPE_SIZE
+
+// A one-way byte stream shared by every descriptor open on either end
+typedef struct pipe {
+    uint8_t* buf;               // PIPE_SIZE byte ring
+    uint32_t head;              // offset of the next byte to read
+    uint32_t count;             // bytes waiting to be read
+    uint32_t readers;           // descriptors open on the read end
+    uint32_t writers;           // descriptors open on the write end
+    wait_queue_t readable;      // readers sleep here while the ring is empty
+    wait_queue_t writable;      // writers sleep here while the ring is full
+} pipe_t;
+
+// Sets up the cache pipes are allocated from
+extern void pipe_init();
+
+// Creates a pipe and opens both ends in the given file entries
+extern int32_t pipe_create(fentry_t* read_end, fentry_t* write_end);
+
+// Counts a copied file entry as another descriptor on its pipe, ignores other files
+extern void pipe_dup(fentry_t* file);
+
+// pipe file operations
+extern int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes);
+extern int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes);
+extern int32_t pipe_open(const uint8_t* filename);
+extern int32_t pipe_close(int32_t fd);
+extern int32_t pipe_fail(int32_t fd, const void* buf, int32_t nbytes);
+
+#endif
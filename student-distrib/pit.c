@@ -1,8 +1,28 @@
 #include "pit.h"
 
-// global variable for pit frequency
+// reload value of channel 0 for the current rate
 uint16_t frequency = 0;
 
+// global tick count
+volatile uint32_t pit_ticks = 0;
+
+// global interrupt count
+volatile uint32_t pit_interrupts = 0;
+
+// ticks a second
+uint32_t pit_hz = PIT_DEFAULT_HZ;
+
+// stop the periodic tick while idle
+uint8_t pit_tickless = 1;
+
+// ticks the armed one-shot stands in for, 0 while the PIT is periodic
+static uint32_t oneshot_ticks = 0;
+
+// tick ALARM goes out on next
+static uint32_t alarm_next = 0;
+
+static void pit_program(uint8_t mode, uint16_t count);
+
 /* 
  * FUNCTION NAME: void pit_init()
  * DESCRIPTION:   initializes pit and enables interrupts
@@ -15,17 +35,14 @@ void pit_init() {
     // set interrupt gate
     set_idt_gate(PIT_INTERRUPT_LOCATION, (uint32_t)pit_handle, KERNEL_CS, GATE_SIZE_32, KERNEL_PRIV, GATE_PRESENT, INTERRUPT_GATE);
 
-    // generate interrupt
-    outb(SQUARE_WAVE, MODE_REGISTER);
-
-    // calculate pit frequency
-    frequency = INPUT_SIGNAL / RELOAD_VALUE;
-
-    // mask value before sending to port
-    outb(frequency & MASK, CHANNEL_0);
+    // start at the rate the boot command line asked for
+    pit_hz = kernel_config.pit_hz;
+    pit_tickless = kernel_config.tickless;
 
-    // right shift to get upper 8 bits
-    outb(frequency >> EIGHT, CHANNEL_0);
+    // calculate the reload value and start the periodic tick
+    frequency = INPUT_SIGNAL / pit_hz;
+    pit_program(SQUARE_WAVE, frequency);
+    alarm_next = pit_ticks + ALARM_SECONDS * pit_hz;
 
     // enable irq 0
     enable_irq(IRQ_0);
@@ -33,16 +50,113 @@ void pit_init() {
 }
 
 /* 
- * FUNCTION NAME: void pit_interrupt_handle()
- * DESCRIPTION:   handler for when a pit interrupt comes in
+ * FUNCTION NAME: int32_t pit_set_hz(uint32_t hz)
+ * DESCRIPTION:   changes the tick rate, and with it the time slice. Pending
+ *                timers are moved so they still fire after the same time
+ * INPUTS:        hz - ticks a second, PIT_MIN_HZ to PIT_MAX_HZ
+ * OUTPUTS:       none
+ * RETURN:        0 on success, -1 if hz is out of range
+ */
+int32_t pit_set_hz(uint32_t hz) {
+    uint32_t flags;
+    if (hz < PIT_MIN_HZ || hz > PIT_MAX_HZ) { return FAILURE; }
+
+    cli_and_save(flags);
+    timer_rescale(pit_ticks, pit_hz, hz);
+    pit_hz = hz;
+    frequency = INPUT_SIGNAL / hz;
+    oneshot_ticks = 0;
+    pit_program(SQUARE_WAVE, frequency);
+    alarm_next = pit_ticks + ALARM_SECONDS * hz;
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* 
+ * FUNCTION NAME: void pit_idle()
+ * DESCRIPTION:   halts until the next interrupt. When tickless, the
+ *                periodic tick is replaced by one interrupt at the next
+ *                timer, as far as the 16 bit counter reaches. If another
+ *                interrupt comes first the ticks that went by are counted
+ *                from the counter. Called with interrupts disabled
  * INPUTS:        none
  * OUTPUTS:       none
  * RETURN:        none
+ */
+void pit_idle() {
+    uint32_t ticks, count, passed;
+
+    if (pit_tickless) {
+        ticks = timer_next(pit_ticks, PIT_MAX_COUNT / frequency);
+        if (alarm_next - pit_ticks < ticks) { ticks = alarm_next - pit_ticks; }
+        if (ticks > 1) {
+            oneshot_ticks = ticks;
+            pit_program(ONE_SHOT, ticks * frequency);
+        }
+    }
+
+    // sti only takes effect after hlt, so no wakeup is missed here
+    asm volatile ("sti; hlt; cli");
+
+    // the handler puts the periodic tick back when the one-shot runs out
+    if (oneshot_ticks != 0) {
+        outb(LATCH_COUNT, MODE_REGISTER);
+        count = inb(CHANNEL_0);
+        count |= inb(CHANNEL_0) << EIGHT;
+        passed = (count > oneshot_ticks * frequency) ? oneshot_ticks : (oneshot_ticks * frequency - count) / frequency;
+
+        // if it ran out just now its interrupt is still pending and counts one
+        if (passed >= oneshot_ticks) { passed = oneshot_ticks - 1; }
+        pit_ticks += passed;
+        oneshot_ticks = 0;
+        pit_program(SQUARE_WAVE, frequency);
+    }
+}
+
+/* 
+ * FUNCTION NAME: void pit_interrupt_handle(interrupt_frame_t* frame)
+ * DESCRIPTION:   handler for when a pit interrupt comes in
+ * INPUTS:        frame - registers pit_handle saved, sampled by the profiler
+ * OUTPUTS:       none
+ * RETURN:        none
  */ 
-void pit_interrupt_handle() {
+void pit_interrupt_handle(interrupt_frame_t* frame) {
+    pit_interrupts++;
+    profile_tick(frame);
+
+    // an idle one-shot ran out, it stood in for several ticks
+    if (oneshot_ticks != 0) {
+        pit_ticks += oneshot_ticks - 1;
+        oneshot_ticks = 0;
+        pit_program(SQUARE_WAVE, frequency);
+    }
+    pit_ticks++;
+
+    if ((int32_t)(pit_ticks - alarm_next) >= 0) {
+        alarm_next += ALARM_SECONDS * pit_hz;
+        signal_alarm();
+    }
+    timer_tick(pit_ticks);
     scheduler();
     // send end of interrupt signal
     send_eoi(IRQ_0);
 
 }
 
+/* 
+ * FUNCTION NAME: void pit_program(uint8_t mode, uint16_t count)
+ * DESCRIPTION:   sets the mode and count of channel 0
+ * INPUTS:        mode - SQUARE_WAVE or ONE_SHOT
+ *                count - input clocks per interrupt
+ * OUTPUTS:       none
+ * RETURN:        none
+ */
+static void pit_program(uint8_t mode, uint16_t count) {
+    outb(mode, MODE_REGISTER);
+
+    // mask value before sending to port
+    outb(count & MASK, CHANNEL_0);
+
+    // right shift to get upper 8 bits
+    outb(count >> EIGHT, CHANNEL_0);
+}
@@ -8,6 +8,10 @@
 #include "idt.h"
 #include "interrupt_invoc.h"
 #include "scheduler.h"
+#include "signal.h"
+#include "timer.h"
+#include "config.h"
+#include "profile.h"
 
 // constants
 #define PIT_INTERRUPT_LOCATION 0x20
@@ -15,15 +19,43 @@
 #define CHANNEL_0              0x40
 #define MODE_REGISTER          0x43
 #define SQUARE_WAVE            0x36
+#define ONE_SHOT               0x30     // channel 0, interrupt on terminal count
+#define LATCH_COUNT            0x00     // channel 0, latch the current count
 #define INPUT_SIGNAL           1193182
-#define RELOAD_VALUE           40
 #define MASK                   0xFF
 #define EIGHT                  8
+#define PIT_MAX_COUNT          0xFFFF
+#define PIT_DEFAULT_HZ         40       // ticks a second, one time slice each
+#define PIT_MIN_HZ             19       // slowest rate the 16 bit reload value allows
+#define PIT_MAX_HZ             1000
+
+/* testing constants */
+#define QUANTUM_BENCH_CYCLES   200000000
+#define QUANTUM_BENCH_IDLE_MS  1000
+
+// number of PIT ticks since pit_init, a one-shot idle period counts for all
+// the ticks it covered
+extern volatile uint32_t pit_ticks;
+
+// number of PIT interrupts since pit_init
+extern volatile uint32_t pit_interrupts;
+
+// ticks a second, the length of a time slice is 1/pit_hz
+extern uint32_t pit_hz;
+
+// stop the periodic tick while idle
+extern uint8_t pit_tickless;
 
 // function to initialize pit
 void pit_init();
 
+// changes the tick rate, pending timers keep their length in time
+int32_t pit_set_hz(uint32_t hz);
+
+// halts until the next interrupt, without the periodic tick when tickless
+void pit_idle();
+
 // handler for pit interrupts
-void pit_interrupt_handle();
+void pit_interrupt_handle(interrupt_frame_t* frame);
 
 #endif
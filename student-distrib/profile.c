@@ -0,0 +1,173 @@
+#include "profile.h"
+#include "serial.h"
+#include "frame_alloc.h"
+#include "pit.h"
+
+// Open addressed histogram keyed by pid, cpl and eip, allocated on the
+// first profile_start
+static profile_sample_t* profile_table = NULL;
+
+// whether the PIT handler records ticks
+static uint8_t profile_on = 0;
+
+uint32_t profile_samples = 0;
+uint32_t profile_dropped = 0;
+
+static void profile_send_number(uint32_t value, int32_t radix, uint8_t end);
+
+/* profile_init
+ * DESCRIPTION: Sets up COM1 for profile_dump and starts sampling right away
+ *              when the boot command line has profile=1
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void profile_init() {
+    serial_init();
+    if (kernel_config.profile) { profile_start(); }
+}
+
+/* profile_start
+ * DESCRIPTION: Empties the histogram and turns sampling on. The table is
+ *              only allocated the first time, a kernel that never profiles
+ *              doesn't pay for it
+ * INPUTS: NONE
+ * OUTPUTS: SUCCESS, FAILURE when out of memory
+ * SIDE EFFECTS: NONE
+ */
+int32_t profile_start() {
+    uint32_t flags;
+    if (profile_table == NULL) {
+        profile_table = (profile_sample_t*)frame_alloc(PROFILE_ORDER);
+        if (profile_table == NULL) { return FAILURE; }
+    }
+
+    cli_and_save(flags);
+    memset(profile_table, 0, PROFILE_SLOTS * sizeof(profile_sample_t));
+    profile_samples = 0;
+    profile_dropped = 0;
+    profile_on = 1;
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* profile_stop
+ * DESCRIPTION: Turns sampling off, the histogram can still be read
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void profile_stop() {
+    profile_on = 0;
+}
+
+/* profile_running
+ * DESCRIPTION: Tells if ticks are being sampled
+ * INPUTS: NONE
+ * OUTPUTS: 1 while sampling, 0 otherwise
+ * SIDE EFFECTS: NONE
+ */
+int32_t profile_running() {
+    return profile_on;
+}
+
+/* profile_tick
+ * DESCRIPTION: Adds one to the bucket of the process, privilege level and
+ *              eip the PIT interrupted. Nearby buckets are probed when the
+ *              hashed one holds another key, and after PROFILE_PROBES the
+ *              sample is only counted as dropped
+ * INPUTS: frame - registers pit_handle saved
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void profile_tick(interrupt_frame_t* frame) {
+    uint32_t slot, probe;
+    uint16_t pid;
+    uint8_t cpl;
+    pcb_t* pcb;
+    profile_sample_t* sample;
+    if (!profile_on) { return; }
+
+    pcb = find_pcb();
+    pid = (pcb != NULL) ? pcb->process_id : PROFILE_NO_PID;
+    cpl = frame->cs & PROFILE_CPL_MASK;
+    slot = ((frame->eip ^ pid) * PROFILE_HASH) >> (32 - PROFILE_SLOT_BITS);
+    profile_samples++;
+
+    for (probe = 0; probe < PROFILE_PROBES; probe++) {
+        sample = &profile_table[(slot + probe) & (PROFILE_SLOTS - 1)];
+        if (sample->count == 0) {
+            sample->eip = frame->eip;
+            sample->pid = pid;
+            sample->cpl = cpl;
+        } else if (sample->eip != frame->eip || sample->pid != pid || sample->cpl != cpl) {
+            continue;
+        }
+        sample->count++;
+        return;
+    }
+    profile_dropped++;
+}
+
+/* profile_copy
+ * DESCRIPTION: Copies the used buckets out in table order
+ * INPUTS: buf - room for max samples
+ *         max - most samples to copy
+ * OUTPUTS: number of samples copied
+ * SIDE EFFECTS: NONE
+ */
+uint32_t profile_copy(profile_sample_t* buf, uint32_t max) {
+    uint32_t flags, slot, copied = 0;
+    if (profile_table == NULL) { return 0; }
+
+    cli_and_save(flags);
+    for (slot = 0; slot < PROFILE_SLOTS && copied < max; slot++) {
+        if (profile_table[slot].count != 0) { buf[copied++] = profile_table[slot]; }
+    }
+    restore_flags(flags);
+    return copied;
+}
+
+/* profile_dump
+ * DESCRIPTION: Sends the histogram over COM1 as text, a header line with
+ *              the sample count, dropped count and PIT rate, then one
+ *              "pid cpl eip count" line per bucket and "end". Sampling is
+ *              paused meanwhile so the dump is consistent
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Polls the serial port, slow on real hardware
+ */
+void profile_dump() {
+    uint32_t slot;
+    uint8_t was_on = profile_on;
+    profile_on = 0;
+
+    serial_puts("profile ");
+    profile_send_number(profile_samples, 10, ' ');
+    profile_send_number(profile_dropped, 10, ' ');
+    profile_send_number(pit_hz, 10, '\n');
+    for (slot = 0; profile_table != NULL && slot < PROFILE_SLOTS; slot++) {
+        if (profile_table[slot].count == 0) { continue; }
+        profile_send_number(profile_table[slot].pid, 10, ' ');
+        profile_send_number(profile_table[slot].cpl, 10, ' ');
+        profile_send_number(profile_table[slot].eip, 16, ' ');
+        profile_send_number(profile_table[slot].count, 10, '\n');
+    }
+    serial_puts("end\n");
+    profile_on = was_on;
+}
+
+/* profile_send_number
+ * DESCRIPTION: Sends a number over COM1 followed by a separator
+ * INPUTS: value - number to send
+ *         radix - 10 or 16
+ *         end - character after it
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void profile_send_number(uint32_t value, int32_t radix, uint8_t end) {
+    int8_t buf[11];
+    int8_t tail[2] = {end, '\0'};
+    serial_puts(itoa(value, buf, radix));
+    serial_puts(tail);
+}
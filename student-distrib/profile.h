@@ -0,0 +1,60 @@
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include "types.h"
+#include "signal.h"
+
+#define PROFILE_SLOT_BITS   12
+#define PROFILE_SLOTS       (1 << PROFILE_SLOT_BITS)
+#define PROFILE_ORDER       4           // frames for the table, 2^4 * 4kB holds PROFILE_SLOTS samples
+#define PROFILE_PROBES      16          // slots looked at before a sample is dropped
+#define PROFILE_HASH        2654435761U // golden ratio multiplier, spreads nearby eips
+#define PROFILE_NO_PID      0xFFFF      // pid of samples taken with no current process
+#define PROFILE_CPL_MASK    0x3         // privilege level in the low bits of cs
+
+// profile system call commands
+#define PROFILE_STOP        0
+#define PROFILE_START       1           // clears the samples and starts over
+#define PROFILE_READ        2           // copies the samples out as profile_sample_t
+#define PROFILE_DUMP        3           // sends the samples over COM1
+
+/* testing constants */
+#define PROFILE_TEST_CYCLES 200000000
+#define PROFILE_TEST_BYTES  0x8000
+
+// One histogram bucket, the number of PIT ticks that interrupted a process
+// at one eip
+typedef struct profile_sample {
+    uint32_t eip;
+    uint16_t pid;
+    uint8_t cpl;                // 0 in the kernel, 3 in user code
+    uint8_t reserved;
+    uint32_t count;             // 0 for a free bucket
+} profile_sample_t;
+
+// ticks sampled and ticks dropped because the table was full, since profile_start
+extern uint32_t profile_samples;
+extern uint32_t profile_dropped;
+
+// Sets up the serial port and starts sampling if the boot command line asked
+extern void profile_init();
+
+// Clears the histogram and samples every PIT tick from now on
+extern int32_t profile_start();
+
+// Stops sampling, the histogram stays until the next start
+extern void profile_stop();
+
+// Whether ticks are being sampled
+extern int32_t profile_running();
+
+// Records where a PIT tick interrupted, called from the PIT handler
+extern void profile_tick(interrupt_frame_t* frame);
+
+// Copies up to max used buckets out, returns how many
+extern uint32_t profile_copy(profile_sample_t* buf, uint32_t max);
+
+// Sends the histogram over COM1 as text for the host to resolve
+extern void profile_dump();
+
+#endif
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Resolves a profile dump from COM1 against kernel and user symbols.
+
+Run QEMU with -serial file:profile.log, press Ctrl+P to start the profiler
+and Ctrl+P again to stop it and send the samples, then run
+
+    ./profile_resolve.py profile.log bootimg [--user PID=ELF ...] [--top N]
+
+Kernel samples (cpl 0) are looked up in bootimg. User samples (cpl 3) are
+looked up in the ELF given for their pid, every program is linked at the
+same address so the pid has to say which one it was.
+"""
+
+import argparse
+import bisect
+import collections
+import subprocess
+import sys
+
+
+def load_symbols(path):
+    """Returns sorted (address, name) pairs for the text symbols of an ELF."""
+    output = subprocess.run(["nm", "-n", path], check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[1] in "tTwW" and not fields[2].startswith("."):
+            symbols.append((int(fields[0], 16), fields[2]))
+    return symbols
+
+
+def resolve(symbols, eip):
+    """Name of the symbol eip falls in, or the raw address."""
+    index = bisect.bisect_right(symbols, (eip, "\xff")) - 1
+    if index < 0:
+        return "0x%x" % eip
+    return symbols[index][1]
+
+
+def read_dump(path):
+    """Returns the header numbers and (pid, cpl, eip, count) of the last dump in a log."""
+    header, samples = None, []
+    with open(path, errors="replace") as log:
+        for line in log:
+            fields = line.split()
+            if fields[:1] == ["profile"]:
+                header, samples = [int(f) for f in fields[1:4]], []
+            elif fields == ["end"]:
+                continue
+            elif header is not None and len(fields) == 4:
+                samples.append((int(fields[0]), int(fields[1]), int(fields[2], 16), int(fields[3])))
+    if header is None:
+        sys.exit("no profile dump in " + path)
+    return header, samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="serial log with the dump")
+    parser.add_argument("kernel", help="bootimg the dump came from")
+    parser.add_argument("--user", action="append", default=[], metavar="PID=ELF",
+                        help="user program that ran as PID")
+    parser.add_argument("--top", type=int, default=20, help="lines to print")
+    args = parser.parse_args()
+
+    (total, dropped, hz), samples = read_dump(args.log)
+    kernel = load_symbols(args.kernel)
+    users = {}
+    for entry in args.user:
+        pid, path = entry.split("=", 1)
+        users[int(pid)] = load_symbols(path)
+
+    counts = collections.Counter()
+    for pid, cpl, eip, count in samples:
+        if cpl == 0:
+            where = "kernel " + resolve(kernel, eip)
+        elif pid in users:
+            where = "user " + resolve(users[pid], eip)
+        else:
+            where = "user 0x%x" % eip
+        counts[(pid, where)] += count
+
+    print("%d samples at %d Hz, %d dropped" % (total, hz, dropped))
+    for (pid, where), count in counts.most_common(args.top):
+        print("%6.2f%% %8d  pid %-5d %s" % (100.0 * count / max(total, 1), count, pid, where))
+
+
+if __name__ == "__main__":
+    main()
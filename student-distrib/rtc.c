@@ -8,18 +8,38 @@
 #include "lib.h"
 #include "interrupt_invoc.h"
 #include "rtc.h"
+#include "wait_queue.h"
+#include "slab.h"
+#include "syscall.h"
+
+// clocks of the open RTC descriptors, counted down on every interrupt
+static rtc_clock_t* rtc_clocks = NULL;
+
+// clock used by kernel code that reads the RTC without a process
+static rtc_clock_t rtc_kernel_clock;
+
+static kmem_cache_t rtc_clock_cache;
+
+// hardware interrupts since boot
+volatile uint32_t rtc_interrupts = 0;
+
+static rtc_clock_t* rtc_get_clock(int32_t fd);
+static void rtc_clock_link(rtc_clock_t* clock, uint32_t period);
+static void rtc_clock_unlink(rtc_clock_t* clock);
 
 
 /* rtc_init()
- * DESCRIPTION: Initializes the RTC and enables interrupts.
- *              Leaves frequency at default.
+ * DESCRIPTION: Initializes the RTC at RTC_BASE_FREQ, which it keeps.
+ *              Its IRQ stays masked until a clock is opened
  * INPUTS: None
  * OUTPUTS: None
  * RETURN: None
  */
 void rtc_init() {
-    // Start off with a slow rate
-    rtc_set_rate(0x0F);
+    kmem_cache_init(&rtc_clock_cache, "rtc_clock", sizeof(rtc_clock_t));
+
+    // Every descriptor's frequency is counted down from this one
+    rtc_set_rate(RTC_BASE_RATE);
 
     // Set up the gate beforehand so things don't get whack
     set_idt_gate(RTC_INTERRUPT_LOCATION, (uint32_t)rtc_handle, KERNEL_CS, GATE_SIZE_32, KERNEL_PRIV, GATE_PRESENT, INTERRUPT_GATE);
@@ -29,12 +49,42 @@ void rtc_init() {
     uint8_t prev_reg = inb(RTC_DATA_PORT);  // Save the previous contents of register B
     outb(RTC_REGISTER_B, RTC_INDEX_PORT);
     outb((prev_reg | RTC_ENABLE_INTERRUPT), RTC_DATA_PORT);
-    
-    // Unmask the interrupts on the IDT
-    enable_irq(RTC_PIC_PORT);
     return;
 }
 
+/* rtc_set_virtual_rate()
+ * DESCRIPTION: Sets the frequency of one clock and starts its period over
+ * INPUTS: clock - clock of a descriptor
+ *         freq - power of 2 from RTC_MIN to RTC_USER_MAX
+ * OUTPUTS: None
+ * RETURN: 0 on success, -1 on failure
+ */
+int32_t rtc_set_virtual_rate(rtc_clock_t* clock, int32_t freq) {
+    uint32_t flags;
+    if (freq < RTC_MIN || freq > RTC_USER_MAX || is_power_2(freq) < 0) { return -1; }
+    cli_and_save(flags);
+    clock->period = RTC_BASE_FREQ / freq;
+    clock->countdown = clock->period;
+    clock->pending = 0;
+    restore_flags(flags);
+    return 0;
+}
+
+/* rtc_dup()
+ * DESCRIPTION: Called on a file entry copied by fork. An RTC descriptor
+ *              gets its own clock at the same frequency, so the two
+ *              processes don't take each other's ticks
+ * INPUTS: file - copied file entry
+ * OUTPUTS: None
+ * RETURN: None
+ */
+void rtc_dup(fentry_t* file) {
+    rtc_clock_t* parent = (rtc_clock_t*)file->object;
+    if (file->flags != OCCUPIED || file->operations_table[CLOSE] != rtc_close || parent == NULL) { return; }
+    file->object = kmem_cache_alloc(&rtc_clock_cache);
+    if (file->object != NULL) { rtc_clock_link((rtc_clock_t*)file->object, parent->period); }
+}
+
 /* rtc_set_rate()
  * DESCRIPTION: Sets the rate at which the RTC will send an interrupt
  * INPUTS: rate - Value from 3-15. The frequency will be right shifted by this value minus 1
@@ -87,8 +137,15 @@ void rtc_interrupt_handle() {
     outb(RTC_REGISTER_C, RTC_INDEX_PORT);
     inb(RTC_DATA_PORT);
 
-    // Clears flag so rtc_read can break if it's running
-    RTC_read_flag = 0x00;
+    // Only the clocks whose period ran out wake their readers
+    rtc_interrupts++;
+    rtc_clock_t* clock;
+    for (clock = rtc_clocks; clock != NULL; clock = clock->next) {
+        if (--clock->countdown != 0) { continue; }
+        clock->countdown = clock->period;
+        clock->pending++;
+        wait_queue_wake_all(&clock->queue);
+    }
     
     // Unmask the interrupts
     send_eoi(RTC_PIC_PORT);
@@ -96,63 +153,139 @@ void rtc_interrupt_handle() {
 }
 
 /* rtc_open()
- * DESCRIPTION: Opens file descriptor for RTC (eventually
- *              Sets rate to 2 HZ
+ * DESCRIPTION: Opens file descriptor for RTC. Its clock starts at 2 Hz
+ *              the first time it is read or written
  * INPUTS:  None
  * OUTPUTS: None
  * RETURN:  0 on success, which is always.
  */
 int32_t rtc_open(const uint8_t* filename) {
-    // Set RTC rate to 2 Hz by default
-    enable_irq(RTC_PIC_PORT);
-    rtc_set_rate(RTC_2_HZ);
     return 0;
 }
 
 /* rtc_read()
- * DESCRIPTION: Holds program until RTC interrupt comes in
- * INPUTS:  None
+ * DESCRIPTION: Holds program until the descriptor's clock ticks. Returns
+ *              right away if it ticked since the last read, so a reader
+ *              that falls behind doesn't lose the time
+ * INPUTS:  fd - RTC descriptor
  * OUTPUTS: None
- * RETURN:  0 on success (which is always unless interrupts are masked)
+ * RETURN:  0 on success, -1 if there is no memory for the clock or a
+ *          signal came before the tick
  */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes) {
-    RTC_read_flag = 0x01;   // Sets flag to watch
-    while (RTC_read_flag == 0x01) { continue; } // Holds program until flag is unset by interrupt handler
+    uint32_t flags;
+    rtc_clock_t* clock = rtc_get_clock(fd);
+    if (clock == NULL) { return -1; }
+    cli_and_save(flags);
+    wait_event(&clock->queue, clock->pending != 0);
+    if (clock->pending == 0) {
+        // a signal cut the wait short
+        restore_flags(flags);
+        return -1;
+    }
+    clock->pending = 0;
+    restore_flags(flags);
     return 0;
 }
 
 /* rtc_write()
- * DESCRIPTION: Sets the RTC Frequency
- * INPUTS:  None
+ * DESCRIPTION: Sets the frequency of the descriptor's clock. The hardware
+ *              keeps running at RTC_BASE_FREQ for everyone else
+ * INPUTS:  fd - RTC descriptor
+ *          buf - int32_t frequency
  * OUTPUTS: 0 on success, -1 on failure
  * RETURN:  None
  */
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes) {
-    int32_t result;
-    int32_t freq = *((int32_t*)(buf));
-    // Make sure desired frequency is within range
-    if (freq < RTC_MIN || freq > RTC_USER_MAX) { result = -1; }
-    else {
-        int8_t rate = 16 - is_power_2(freq);
-        if (rate >= 17) { result = -1; } // Return failure if rtc_frequency isn't a power of 2
-        else { 
-            rtc_set_rate(rate);
-            result = 0;
-        }
-    }
-    return result;
+    rtc_clock_t* clock;
+    if (buf == NULL || (clock = rtc_get_clock(fd)) == NULL) { return -1; }
+    return rtc_set_virtual_rate(clock, *((int32_t*)(buf)));
 }
 
 
 /* rtc_close()
- * DESCRIPTION: Closes file descriptor (eventually)
- * INPUTS: None
+ * DESCRIPTION: Closes file descriptor, freeing its clock
+ * INPUTS: fd - RTC descriptor
  * OUTPUTS: None
  * RETURN: 0 on success, which is always
  *
  */
 int32_t rtc_close(int32_t fd) {
-    return 0; // Nothing for now, as system calls have yet to be implemented.
+    pcb_t* pcb = find_pcb();
+    if (pcb == NULL) {
+        rtc_clock_unlink(&rtc_kernel_clock);
+        return 0;
+    }
+    rtc_clock_t* clock = (rtc_clock_t*)pcb->file_array[fd].object;
+    if (clock != NULL) {
+        rtc_clock_unlink(clock);
+        kmem_cache_free(clock);
+        pcb->file_array[fd].object = NULL;
+    }
+    return 0;
+}
+
+/* rtc_get_clock()
+ * DESCRIPTION: Finds the clock of a descriptor, making it at 2 Hz the first
+ *              time. Kernel code without a process shares rtc_kernel_clock
+ * INPUTS: fd - RTC descriptor
+ * OUTPUTS: None
+ * RETURN: the clock, NULL when out of memory
+ */
+static rtc_clock_t* rtc_get_clock(int32_t fd) {
+    pcb_t* pcb = find_pcb();
+    if (pcb == NULL) {
+        if (rtc_kernel_clock.period == 0) { rtc_clock_link(&rtc_kernel_clock, RTC_BASE_FREQ / RTC_MIN); }
+        return &rtc_kernel_clock;
+    }
+    fentry_t* file = &(pcb->file_array[fd]);
+    if (file->object == NULL && (file->object = kmem_cache_alloc(&rtc_clock_cache)) != NULL) {
+        rtc_clock_link((rtc_clock_t*)file->object, RTC_BASE_FREQ / RTC_MIN);
+    }
+    return (rtc_clock_t*)file->object;
+}
+
+/* rtc_clock_link()
+ * DESCRIPTION: Starts a clock and puts it on the list the interrupt counts
+ *              down. The first clock unmasks the RTC's IRQ
+ * INPUTS: clock - clock to start
+ *         period - hardware interrupts per tick
+ * OUTPUTS: None
+ * RETURN: None
+ */
+static void rtc_clock_link(rtc_clock_t* clock, uint32_t period) {
+    uint32_t flags;
+    cli_and_save(flags);
+    clock->period = period;
+    clock->countdown = period;
+    clock->pending = 0;
+    wait_queue_init(&clock->queue);
+    clock->prev = NULL;
+    clock->next = rtc_clocks;
+    if (clock->next != NULL) { clock->next->prev = clock; }
+    else { rtc_enable_irq(); }
+    rtc_clocks = clock;
+    restore_flags(flags);
+}
+
+/* rtc_clock_unlink()
+ * DESCRIPTION: Takes a clock off the list. With the last one gone the RTC
+ *              doesn't interrupt anymore
+ * INPUTS: clock - clock to stop
+ * OUTPUTS: None
+ * RETURN: None
+ */
+static void rtc_clock_unlink(rtc_clock_t* clock) {
+    uint32_t flags;
+    cli_and_save(flags);
+    if (clock->period != 0) {
+        if (clock->prev != NULL) { clock->prev->next = clock->next; }
+        else { rtc_clocks = clock->next; }
+        if (clock->next != NULL) { clock->next->prev = clock->prev; }
+        if (rtc_clocks == NULL) { rtc_disable_irq(); }
+        clock->period = 0;
+    }
+    restore_flags(flags);
 }
 
 #endif
@@ -1,6 +1,9 @@
 #ifndef _RTC_H
 #define _RTC_H
 
+#include "types.h"
+#include "wait_queue.h"
+
 #define RTC_PIC_PORT 0x08
 #define RTC_INTERRUPT_LOCATION 0x28
 
@@ -19,24 +22,45 @@
 #define RTC_USER_MAX    0x0400
 
 #define RTC_2_HZ        0x0F
-
+#define RTC_BASE_RATE   0x06            // hardware rate value for RTC_USER_MAX Hz
+#define RTC_BASE_FREQ   RTC_USER_MAX    // the RTC always interrupts this often
+
+/* testing constants */
+#define RTC_TEST_FAST   512
+#define RTC_TEST_SLOW   64
+#define RTC_TEST_READS  8
+
+// Frequency of one open RTC descriptor, counted down from the hardware rate
+typedef struct rtc_clock {
+    struct rtc_clock* next;     // neighbours on the list of open clocks
+    struct rtc_clock* prev;
+    uint32_t period;            // hardware interrupts per virtual tick
+    uint32_t countdown;         // hardware interrupts left until the next one
+    uint32_t pending;           // virtual ticks since the last rtc_read
+    wait_queue_t queue;         // rtc_read sleeps here
+} rtc_clock_t;
+
+struct fentry;
 
 int8_t RTC_FLAG;
 
-/* Flag for rtc_read */
-int8_t RTC_read_flag;
-
 /* Buffer for rtc_frequency */
 uint32_t rtc_frequency;
 
+/* Hardware interrupts since boot */
+extern volatile uint32_t rtc_interrupts;
+
 /* Initializes the RTC */
 extern void rtc_init();
 
 /* Extern for now, change later */
 extern void rtc_set_rate(uint8_t rate);
 
-/* Function for later use when virtualizing */
-extern void rtc_set_virtual_rate(uint8_t prog_num, uint8_t rate);
+/* Sets the frequency of one descriptor's clock */
+extern int32_t rtc_set_virtual_rate(rtc_clock_t* clock, int32_t freq);
+
+/* Gives a copied RTC descriptor a clock of its own, ignores other files */
+extern void rtc_dup(struct fentry* file);
 
 /* Enable interrupts from RTC */
 extern void rtc_enable_irq();
@@ -47,16 +71,16 @@ extern void rtc_disable_irq();
 /* Handler for RTC interrupts */
 extern void rtc_interrupt_handle();
 
-/* Opens file descriptor (Eventually) */
+/* Opens file descriptor */
 extern int32_t rtc_open(const uint8_t* filename);
 
-/* Holds function until RTC interrupt comes in */
+/* Holds function until the descriptor's clock ticks */
 extern int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
 
-/* Changes RTC frequency to whatever is in rtc_frequency */
+/* Changes the descriptor's frequency */
 extern int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
 
-/* Closes file descriptor (eventually) */
+/* Closes file descriptor */
 extern int32_t rtc_close(int32_t fd);
 
 #endif
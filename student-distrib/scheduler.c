@@ -2,83 +2,298 @@
 #define _SCHEDULER_C
 
 #include "scheduler.h"
+#include "pit.h"
 char* keys[3] = {keyboard_buf_0, keyboard_buf_1, keyboard_buf_2};
 int8_t terminal_colors[3] = {BLACK + (WHITE << BACKGROUND), LIGHT_RED + (DARK_GRAY << BACKGROUND), LIGHT_GREEN + (LIGHT_BLUE << BACKGROUND)};
 
+// Circular list of the runnable processes
+static pcb_t* run_queue = NULL;
+
+// Saved esp of the boot context, which runs whenever nothing else can
+static uint32_t idle_esp;
+
+// Halted processes whose kernel stacks may still be in use, linked
+// through wait_next
+static pcb_t* zombies = NULL;
+
+static void set_terminal_context(uint8_t term);
+static void start_terminal(uint8_t term);
+static void terminal_shell_entry();
+static void reap_zombies(pcb_t* running);
+
 /*
  * scheduler
- * DESCRIPTION: Switches the current process to the next one
+ * DESCRIPTION: Called on every PIT tick. Starts the shell of one terminal
+ *              that doesn't have one yet, otherwise gives the CPU to the
+ *              next runnable process
  * INPUTS:  NONE
  * OUTPUTS: NONE
- * SIDE EFFECTS: NONE
+ * SIDE EFFECTS: May switch processes
  */
 void scheduler() {
-    // Get the process ID and terminal number of the next terminal
-    uint8_t next_term = (cur_scheduled_terminal + 1) % 3;
-    int8_t next_process_num = terminal_process_nums[next_term];
-    
-    // Check if this is the first time running the scheduler
-    if (next_term != 1 || next_process_num != NOT_ASSIGNED) {
-        scheduler_save_reg(); // Save the ebp of the scheduler for when we come back
+    uint8_t term;
+
+    // Send an eoi to the PIT so that another interrupt can come in, the
+    // process we switch to may not return through the PIT handler
+    send_eoi(0);
+
+    for (term = 0; term < kernel_config.terminals; term++) {
+        if (terminal_process_nums[term] == NOT_ASSIGNED) {
+            start_terminal(term);
+            return;
+        }
     }
-    // Check if this is the first time we're switching to the next process
-    if (next_process_num == NOT_ASSIGNED) {
-        terminal_process_nums[next_term] = next_available_process();
+    schedule();
+}
+
+/*
+ * schedule
+ * DESCRIPTION: Switches from the current process to the one after it on the
+ *              run queue. Blocked processes are not on the queue, so they
+ *              don't get any time until they are woken. When nothing is
+ *              runnable the boot context idles with hlt. Must be called with
+ *              interrupts disabled
+ * INPUTS:  NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Changes the current pcb, paging, tss and terminal globals
+ */
+void schedule() {
+    pcb_t* prev = find_pcb();
+    pcb_t* next;
+    uint32_t* save_esp = (prev == NULL) ? &idle_esp : &(prev->context_esp);
+
+    reap_zombies(prev);
+    if (prev != NULL && prev->state == PROCESS_RUNNABLE) { next = prev->run_next; }
+    else { next = run_queue; }
+    if (next == prev) { return; }
+
+    // Nothing is runnable, let the idle loop wait for an interrupt
+    if (next == NULL) {
         set_pcb(NULL);
-        const char* shell = "shell";
-	cur_scheduled_terminal = next_term;
-	//sets the keyboard buf to scheduled one
-        keyboard_buf = keys[cur_scheduled_terminal];
-        VIDEO_MEM_OFFSET = cur_terminal == cur_scheduled_terminal ? 0 : (cur_scheduled_terminal + 1)*FOUR_KB;
-	//Calculates the VIDEO_MEM_OFFSET based off the cur scheduled terminal unless its the same as the cur_terminal
-        ARRTIB = terminal_colors[cur_scheduled_terminal];
-    
-        send_eoi(0);
-        execute((uint8_t*)shell);
+        switch_context(save_esp, idle_esp);
         return;
     }
-    // If the terminal is running a process, ensure that we switch to that PCB
-    pcb_t* next_pcb = (pcb_t*)(PHYS_PAGE_START - ((next_process_num + 1) * PROG_STACK_SIZE));
-    while (next_pcb->child_pcb != NULL) { next_pcb = next_pcb->child_pcb; }
-    next_process_num = next_pcb->process_id;
-   
-    // Change the PCB
-    set_pcb(next_pcb);
-    
-    // Setup paging for next process
-    uint32_t* program_page = get_page_directory(PROG_PAGE_IDX);
-    uint32_t prog_mem = PHYS_PAGE_START + (PROGRAM_SIZE * next_process_num);
-    *program_page = 0x00000000;
-    *program_page = prog_mem | FLAG_P | FLAG_RW | FLAG_US | FLAG_PS;
-    
-    // Flush TLB
+    run_queue = next->run_next;
+
+    // Change the PCB and set up paging for next process
+    set_pcb(next);
+    map_process_pages(next->process_id);
+    set_terminal_context(next->terminal);
+
+    // ss0 will contain the location of the Kernel Data Segment
+    tss.ss0 =  KERNEL_DS;
+    // esp0 will point to the new stack pointer
+    tss.esp0 = pcb_stack_top(next);
+
+    // Call assembly function to do final switch
+    switch_context(save_esp, next->context_esp);
+}
+
+/*
+ * scheduler_idle
+ * DESCRIPTION: Runs on the boot stack forever. Hands the CPU to runnable
+ *              processes and halts until the next interrupt otherwise
+ * INPUTS:  NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void scheduler_idle() {
+    // processes switched to from here iret straight to user space, which
+    // nulls a kernel-only data segment, so use the user one like they do
     asm volatile (
-        "mov %%cr3, %%eax;"
-        "mov %%eax, %%cr3;"
+        "movw %0, %%ds;"
+        "movw %0, %%es;"
         :
-        :
-        :"%eax"
+        : "r"((uint16_t)USER_DS)
     );
-    
-    // Set the current terminal to the next one
-    cur_scheduled_terminal = next_term;
+    while (1) {
+        cli();
+        schedule();
+        pit_idle();
+    }
+}
+
+/*
+ * run_queue_add
+ * DESCRIPTION: Puts a process at the back of the run queue
+ * INPUTS:  pcb - process to add
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void run_queue_add(pcb_t* pcb) {
+    if (pcb->run_next != NULL) { return; }
+    if (run_queue == NULL) {
+        pcb->run_next = pcb;
+        pcb->run_prev = pcb;
+        run_queue = pcb;
+        return;
+    }
+    pcb->run_next = run_queue;
+    pcb->run_prev = run_queue->run_prev;
+    run_queue->run_prev->run_next = pcb;
+    run_queue->run_prev = pcb;
+}
+
+/*
+ * run_queue_remove
+ * DESCRIPTION: Takes a process off the run queue
+ * INPUTS:  pcb - process to remove
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void run_queue_remove(pcb_t* pcb) {
+    if (pcb->run_next == NULL) { return; }
+    if (pcb->run_next == pcb) {
+        run_queue = NULL;
+    } else {
+        pcb->run_prev->run_next = pcb->run_next;
+        pcb->run_next->run_prev = pcb->run_prev;
+        if (run_queue == pcb) { run_queue = pcb->run_next; }
+    }
+    pcb->run_next = NULL;
+    pcb->run_prev = NULL;
+}
+
+/*
+ * scheduler_exit
+ * DESCRIPTION: Marks a halted process as a zombie and switches away from it
+ *              for the last time. If its owner is still around it is woken
+ *              and frees the zombie in wait, otherwise the pid, pcb and
+ *              kernel stack are freed by the next schedule that runs on
+ *              some other stack. Must be called with interrupts disabled,
+ *              after the process' pages are released and it is off the run
+ *              queue
+ * INPUTS:  pcb - the current process
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Never returns
+ */
+void scheduler_exit(pcb_t* pcb) {
+    pcb->state = PROCESS_ZOMBIE;
+    if (pcb->owner != NULL) {
+        wait_queue_wake_all(&(pcb->owner->child_exit));
+    } else {
+        pcb->wait_next = zombies;
+        zombies = pcb;
+    }
+    schedule();
+}
+
+/*
+ * scheduler_orphan
+ * DESCRIPTION: Called when a process halts. Its forked and spawned children
+ *              lose their owner, and the ones that already halted are
+ *              handed to the scheduler to free since nobody will wait
+ *              for them. Must be called with interrupts disabled
+ * INPUTS:  parent - the halting process
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void scheduler_orphan(pcb_t* parent) {
+    uint32_t pid;
+    for (pid = 0; pid < max_processes; pid++) {
+        pcb_t* child = get_pcb(pid);
+        if (child == NULL || child->owner != parent) { continue; }
+        child->owner = NULL;
+        if (child->state == PROCESS_ZOMBIE) {
+            child->wait_next = zombies;
+            zombies = child;
+        }
+    }
+}
+
+/*
+ * scheduler_new_context
+ * DESCRIPTION: Lays out the registers switch_context pops just below esp
+ *              on a process' kernel stack, returning into entry with
+ *              interrupts still disabled
+ * INPUTS:  esp - where the context goes, usually pcb_stack_top of a process
+ *                that was given a stack by pcb_alloc
+ *          entry - function the context starts in, it must never return
+ * OUTPUTS: esp to pass to switch_context
+ * SIDE EFFECTS: Overwrites the kernel stack below esp
+ */
+uint32_t scheduler_new_context(uint32_t esp, void (*entry)()) {
+    uint32_t* stack = (uint32_t*)esp;
+    int i;
+    *(--stack) = (uint32_t)entry;
+    for (i = 0; i < CONTEXT_REGS; i++) { *(--stack) = 0; }
+    return (uint32_t)stack;
+}
+
+/*
+ * set_terminal_context
+ * DESCRIPTION: Points the keyboard buffer, cursor and text colour at the
+ *              given terminal
+ * INPUTS:  term - terminal of the process about to run
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void set_terminal_context(uint8_t term) {
+    cur_scheduled_terminal = term;
     keyboard_buf = keys[cur_scheduled_terminal]; //sets the keyboard_buf to the scheduled one
-    VIDEO_MEM_OFFSET = cur_terminal == cur_scheduled_terminal ? 0 : (cur_scheduled_terminal + 1)*FOUR_KB; //calculates the VIDEO_MEM_OFFSET based off the cure_scheduled terminal in relation to the cur_terminal
     if (cur_scheduled_terminal != cur_terminal) {CURSOR = 0;} //sets the cursor on if the scheduled terminal is the current terminal
     else {CURSOR = 1;}
     ARRTIB = terminal_colors[cur_scheduled_terminal]; //changes text_colour to match the terminal
+}
 
-    // ss0 will contain the location of the Kernel Data Segment
-    tss.ss0 =  KERNEL_DS;
-    // esp0 will point to the new stack pointer
-    tss.esp0 = PHYS_PAGE_START - (next_process_num * PROG_STACK_SIZE) - LONG;
-    
-    // Send an eoi to the PIT so that another interrupt can come in
-    send_eoi(0);
-    // Call assembly function to do final switch
-    scheduler_switch_process(next_pcb->scheduler_ebp);
-    
-    return; 
+/*
+ * start_terminal
+ * DESCRIPTION: Builds a context on the kernel stack of the process the
+ *              terminal's shell will get, which starts in
+ *              terminal_shell_entry, and switches to it
+ * INPUTS:  term - terminal that has no shell yet
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void start_terminal(uint8_t term) {
+    pcb_t* prev = find_pcb();
+    int32_t process_num = next_available_process();
+    if (process_num == FAILURE || pcb_alloc(process_num) == NULL) { return; }
+    terminal_process_nums[term] = process_num;
+
+    set_pcb(NULL);
+    set_terminal_context(term);
+    switch_context((prev == NULL) ? &idle_esp : &(prev->context_esp), scheduler_new_context(pcb_stack_top(get_pcb(process_num)), terminal_shell_entry));
+}
+
+/*
+ * reap_zombies
+ * DESCRIPTION: Frees every zombie except the one still running, whose
+ *              stack is in use until it switches away
+ * INPUTS:  running - process schedule is called on, may be NULL
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Frees pids, pcbs and frames
+ */
+static void reap_zombies(pcb_t* running) {
+    pcb_t** link = &zombies;
+    while (*link != NULL) {
+        pcb_t* zombie = *link;
+        if (zombie == running) {
+            link = &(zombie->wait_next);
+            continue;
+        }
+        *link = zombie->wait_next;
+        pid_release(zombie->process_id);
+        pcb_free(zombie->process_id);
+    }
+}
+
+/*
+ * terminal_shell_entry
+ * DESCRIPTION: First code run in a context made by start_terminal
+ * INPUTS:  NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Executes a shell on cur_scheduled_terminal
+ */
+static void terminal_shell_entry() {
+    uint32_t unused;
+    const char* shell = "shell";
+    execute((uint8_t*)shell);
+
+    // only gets here if the shell couldn't be started
+    terminal_process_nums[cur_scheduled_terminal] = NOT_ASSIGNED;
+    cli();
+    switch_context(&unused, idle_esp);
 }
 
 #endif
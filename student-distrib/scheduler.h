@@ -6,7 +6,6 @@
 #include "x86_desc.h"
 #include "i8259.h"
 #include "pcb.h"
-#include "pcb_asm.h"
 #include "paging.h"
 #include "multi_term.h"
 #include "scheduler_asm.h"
@@ -20,12 +19,41 @@
 #define NOT_ASSIGNED    -1
 #define MAX_TERMINALS   3
 
+/* testing constants */
+#define CPU_TEST_TICKS  40      // about a second of PIT ticks
+#define PINGPONG_ROUNDS 10000
+
 // Stores the process numbers of the base shells of the terminals
-int8_t terminal_process_nums[MAX_TERMINALS];
+int32_t terminal_process_nums[MAX_TERMINALS];
 
 // Whichever terminal is currently running
 uint8_t cur_scheduled_terminal;
 
+// Text and background colour of each terminal
+extern int8_t terminal_colors[MAX_TERMINALS];
+
+// Handles a PIT tick, starting terminal shells and rotating the run queue
 void scheduler();
 
+// Switches to the next runnable process, or to the idle loop if there is none
+void schedule();
+
+// Loop run by the boot context once the kernel is set up
+void scheduler_idle();
+
+// Adds or removes a process from the run queue. pcb.h can include this
+// header before pcb_t is defined, so the struct is declared here
+struct pcb_t;
+void run_queue_add(struct pcb_t* pcb);
+void run_queue_remove(struct pcb_t* pcb);
+
+// Builds a kernel context below esp that starts in entry
+uint32_t scheduler_new_context(uint32_t esp, void (*entry)());
+
+// Takes a halted process off the CPU for good, its memory is freed later
+void scheduler_exit(struct pcb_t* pcb);
+
+// Lets the children of a halting process be freed without a wait
+void scheduler_orphan(struct pcb_t* parent);
+
 #endif
@@ -3,6 +3,9 @@
 
 #include "types.h"
 
-extern void scheduler_switch_process(uint32_t ebp);
+// number of registers switch_context keeps on a saved stack
+#define CONTEXT_REGS    4
+
+extern void switch_context(uint32_t* save_esp, uint32_t next_esp);
 
 #endif
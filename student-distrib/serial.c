@@ -0,0 +1,43 @@
+#include "serial.h"
+#include "lib.h"
+
+/* serial_init
+ * DESCRIPTION: Sets COM1 to 115200 baud 8N1 with the FIFOs on. Its
+ *              interrupt stays off, output is polled
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void serial_init() {
+    outb(0x00, COM1 + SERIAL_INT_ENABLE);
+    outb(SERIAL_DLAB, COM1 + SERIAL_LINE_CONTROL);
+    outb(SERIAL_DIVISOR & 0xFF, COM1 + SERIAL_DIVISOR_LOW);
+    outb(SERIAL_DIVISOR >> 8, COM1 + SERIAL_DIVISOR_HIGH);
+    outb(SERIAL_8N1, COM1 + SERIAL_LINE_CONTROL);
+    outb(SERIAL_FIFO_ON, COM1 + SERIAL_FIFO);
+    outb(SERIAL_DTR_RTS, COM1 + SERIAL_MODEM);
+}
+
+/* serial_putc
+ * DESCRIPTION: Waits until the transmitter has room and sends a byte
+ * INPUTS: c - byte to send
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void serial_putc(uint8_t c) {
+    while ((inb(COM1 + SERIAL_LINE_STATUS) & SERIAL_THR_EMPTY) == 0);
+    outb(c, COM1 + SERIAL_DATA);
+}
+
+/* serial_puts
+ * DESCRIPTION: Sends a string, with "\r\n" for every '\n'
+ * INPUTS: s - NUL terminated string
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void serial_puts(const int8_t* s) {
+    for (; *s != '\0'; s++) {
+        if (*s == '\n') { serial_putc('\r'); }
+        serial_putc(*s);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include "types.h"
+
+#define COM1                0x3F8
+#define SERIAL_DATA         0       // offsets from the port base
+#define SERIAL_INT_ENABLE   1
+#define SERIAL_DIVISOR_LOW  0       // while SERIAL_DLAB is set
+#define SERIAL_DIVISOR_HIGH 1
+#define SERIAL_FIFO         2
+#define SERIAL_LINE_CONTROL 3
+#define SERIAL_MODEM        4
+#define SERIAL_LINE_STATUS  5
+
+#define SERIAL_DLAB         0x80    // line control, divisor latch access
+#define SERIAL_8N1          0x03    // line control, 8 data bits, no parity, 1 stop bit
+#define SERIAL_FIFO_ON      0xC7    // enable and clear the FIFOs
+#define SERIAL_DTR_RTS      0x03    // modem control, data terminal ready and request to send
+#define SERIAL_THR_EMPTY    0x20    // line status, room to send
+#define SERIAL_DIVISOR      1       // 115200 baud
+
+// Sets up COM1 for polled output, no interrupts
+extern void serial_init();
+
+// Sends one byte, waiting for room
+extern void serial_putc(uint8_t c);
+
+// Sends a NUL terminated string
+extern void serial_puts(const int8_t* s);
+
+#endif
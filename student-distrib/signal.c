@@ -0,0 +1,185 @@
+#include "signal.h"
+#include "syscall.h"
+#include "scheduler.h"
+#include "exception.h"
+
+// movl $SIGRETURN_CALL, %eax; int $0x80; nop. Copied onto the user stack
+// as the return address of every handler
+static const uint8_t sigreturn_linkage[SIGNAL_LINKAGE_SIZE] = {0xB8, SIGRETURN_CALL, 0x00, 0x00, 0x00, 0xCD, 0x80, 0x90};
+
+static void signal_setup(pcb_t* pcb, signal_context_t* context, uint32_t* eip, uint32_t* esp);
+
+/* signal_raise
+ * DESCRIPTION: Marks a signal pending in a process, it is delivered when
+ *              the process returns to user space. A process blocked in a
+ *              system call is woken if the signal would run a handler or
+ *              kill it, the call then fails so that happens promptly
+ * INPUTS: pcb - process to signal
+ *         signum - signal number
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void signal_raise(pcb_t* pcb, uint32_t signum) {
+    uint32_t flags;
+    if (pcb == NULL || signum >= NUM_SIGNALS) { return; }
+    cli_and_save(flags);
+    pcb->signals_pending |= 1 << signum;
+    if (pcb->state == PROCESS_BLOCKED && signal_interrupts(pcb)) { wait_queue_wake(pcb); }
+    restore_flags(flags);
+}
+
+/* signal_interrupts
+ * DESCRIPTION: Checks for a pending signal that isn't masked and either has
+ *              a handler or kills by default, one a sleep has to end for.
+ *              ALARM and USER1 without a handler would just be dropped
+ * INPUTS: pcb - process to check
+ * OUTPUTS: 1 if there is one, 0 otherwise
+ * SIDE EFFECTS: NONE
+ */
+int32_t signal_interrupts(pcb_t* pcb) {
+    uint32_t signum;
+    uint32_t pending = pcb->signals_pending & ~pcb->signals_masked;
+    for (signum = 0; signum < NUM_SIGNALS; signum++) {
+        if (!(pending & (1 << signum))) { continue; }
+        if (pcb->signal_handlers[signum] != NULL) { return 1; }
+        if (signum != SIGNAL_ALARM && signum != SIGNAL_USER1) { return 1; }
+    }
+    return 0;
+}
+
+/* signal_exception
+ * DESCRIPTION: Raises the signal for an exception in user code when the
+ *              process can take it. Without a handler, or with the signal
+ *              masked because a handler is running, returning to user space
+ *              would only fault on the same instruction again
+ * INPUTS: pcb - process that faulted
+ *         signum - SIGNAL_DIV_ZERO or SIGNAL_SEGFAULT
+ * OUTPUTS: SUCCESS if the signal was raised, FAILURE if the process has to
+ *          be halted
+ * SIDE EFFECTS: NONE
+ */
+int32_t signal_exception(pcb_t* pcb, uint32_t signum) {
+    if (pcb->signal_handlers[signum] == NULL || (pcb->signals_masked & (1 << signum))) { return FAILURE; }
+    signal_raise(pcb, signum);
+    return SUCCESS;
+}
+
+/* signal_foreground
+ * DESCRIPTION: Raises a signal in the program at the end of a terminal's
+ *              execute chain, the one the user is typing to
+ * INPUTS: terminal - terminal number
+ *         signum - signal number
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void signal_foreground(uint8_t terminal, uint32_t signum) {
+    int32_t root = terminal_process_nums[terminal];
+    if (root < 0 || !pid_in_use(root)) { return; }
+    pcb_t* pcb = get_pcb(root);
+    while (pcb->child_pcb != NULL) { pcb = pcb->child_pcb; }
+    signal_raise(pcb, signum);
+}
+
+/* signal_alarm
+ * DESCRIPTION: Raises ALARM in every process with a handler for it, the
+ *              rest would ignore it anyway
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void signal_alarm() {
+    uint32_t pid;
+    for (pid = 0; pid < max_processes; pid++) {
+        pcb_t* pcb = get_pcb(pid);
+        if (pcb != NULL && pid_in_use(pid) && pcb->signal_handlers[SIGNAL_ALARM] != NULL) {
+            signal_raise(pcb, SIGNAL_ALARM);
+        }
+    }
+}
+
+/* signal_interrupt_exit
+ * DESCRIPTION: Called by every interrupt and exception stub before iret.
+ *              When user code was interrupted and has a signal pending, the
+ *              frame is changed to return into its handler instead
+ * INPUTS: frame - registers the stub saved
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: May halt the current process
+ */
+void signal_interrupt_exit(interrupt_frame_t* frame) {
+    if (frame->cs != USER_CS) { return; }
+    pcb_t* pcb = find_pcb();
+    if (pcb == NULL || (pcb->signals_pending & ~pcb->signals_masked) == 0) { return; }
+
+    signal_context_t context = {frame->ebx, frame->ecx, frame->edx, frame->esi, frame->edi,
+                                frame->ebp, frame->eax, frame->eip, frame->eflags, frame->esp};
+    signal_setup(pcb, &context, &frame->eip, &frame->esp);
+}
+
+/* signal_syscall_exit
+ * DESCRIPTION: Called by syscall_handle before iret, the same as
+ *              signal_interrupt_exit for the system call frame
+ * INPUTS: frame - registers syscall_handle saved
+ *         ret - return value of the system call
+ * OUTPUTS: ret, which stays in eax
+ * SIDE EFFECTS: May halt the current process
+ */
+int32_t signal_syscall_exit(syscall_frame_t* frame, int32_t ret) {
+    if (frame->cs != USER_CS) { return ret; }
+    pcb_t* pcb = find_pcb();
+    if (pcb == NULL || (pcb->signals_pending & ~pcb->signals_masked) == 0) { return ret; }
+
+    signal_context_t context = {frame->ebx, frame->ecx, frame->edx, frame->esi, frame->edi,
+                                frame->ebp, ret, frame->eip, frame->eflags, frame->esp};
+    signal_setup(pcb, &context, &frame->eip, &frame->esp);
+    return ret;
+}
+
+/* signal_setup
+ * DESCRIPTION: Takes pending signals lowest number first. Ignored ones are
+ *              dropped and one that kills halts the process. For one with a
+ *              handler the user stack gets the sigreturn linkage, the saved
+ *              registers, the signal number and a return address into the
+ *              linkage, and the process returns into the handler with every
+ *              signal masked until sigreturn
+ * INPUTS: pcb - current process
+ *         context - its user registers
+ *         eip, esp - where it returns to, changed for a handler
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Writes to the user stack, may halt the current process
+ */
+static void signal_setup(pcb_t* pcb, signal_context_t* context, uint32_t* eip, uint32_t* esp) {
+    uint32_t flags, signum, pending, sp, linkage;
+
+    cli_and_save(flags);
+    while ((pending = pcb->signals_pending & ~pcb->signals_masked) != 0) {
+        asm ("bsfl %1, %0" : "=r"(signum) : "r"(pending));
+        pcb->signals_pending &= ~(1 << signum);
+
+        if (pcb->signal_handlers[signum] == NULL) {
+            if (signum == SIGNAL_ALARM || signum == SIGNAL_USER1) { continue; }
+            restore_flags(flags);
+            halt((signum == SIGNAL_INTERRUPT) ? 0 : EXCEPTION);
+            return;
+        }
+
+        // the frame has to fit in the program page below the interrupted stack
+        sp = context->esp - SIGNAL_LINKAGE_SIZE - sizeof(signal_context_t) - 2 * LONG;
+        if (context->esp > VIRT_PAGE_START + PROGRAM_SIZE || sp < VIRT_PAGE_START) {
+            restore_flags(flags);
+            halt(EXCEPTION);
+            return;
+        }
+        linkage = context->esp - SIGNAL_LINKAGE_SIZE;
+        memcpy((void*)linkage, sigreturn_linkage, SIGNAL_LINKAGE_SIZE);
+        memcpy((void*)(linkage - sizeof(signal_context_t)), context, sizeof(signal_context_t));
+        ((uint32_t*)sp)[1] = signum;
+        ((uint32_t*)sp)[0] = linkage;
+
+        pcb->signals_masked = SIGNAL_ALL;
+        *eip = (uint32_t)pcb->signal_handlers[signum];
+        *esp = sp;
+        restore_flags(flags);
+        return;
+    }
+    restore_flags(flags);
+}
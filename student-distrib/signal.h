@@ -0,0 +1,85 @@
+#ifndef _SIGNAL_H
+#define _SIGNAL_H
+
+#include "types.h"
+
+// signal numbers, lower numbers are delivered first
+#define SIGNAL_DIV_ZERO     0   // divide error, kills by default
+#define SIGNAL_SEGFAULT     1   // any other exception, kills by default
+#define SIGNAL_INTERRUPT    2   // ctrl-c on the process' terminal, kills by default
+#define SIGNAL_ALARM        3   // every ALARM_SECONDS, ignored by default
+#define SIGNAL_USER1        4   // ignored by default
+#define NUM_SIGNALS         5
+#define SIGNAL_ALL          ((1 << NUM_SIGNALS) - 1)
+
+#define ALARM_SECONDS       10
+#define SIGRETURN_CALL      10      // system call number the linkage code makes
+#define SIGNAL_LINKAGE_SIZE 8       // linkage code rounded up to a long
+#define EFLAGS_USER         0xDD5   // CF PF AF ZF SF TF DF OF, the flags sigreturn may restore
+
+/* testing constants */
+#define SIGNAL_TEST_ROUNDS  1000
+#define SIGNAL_TEST_RET     42
+
+// Registers on the kernel stack while an interrupt or exception handler
+// runs, lowest address first. The stubs push the error code, or 0 when the
+// processor has none, then pushal, the processor pushes the rest. esp and
+// ss are only there when the interrupt came from user space
+typedef struct interrupt_frame {
+    uint32_t edi;
+    uint32_t esi;
+    uint32_t ebp;
+    uint32_t kernel_esp;
+    uint32_t ebx;
+    uint32_t edx;
+    uint32_t ecx;
+    uint32_t eax;
+    uint32_t error_code;
+    uint32_t eip;
+    uint32_t cs;
+    uint32_t eflags;
+    uint32_t esp;
+    uint32_t ss;
+} interrupt_frame_t;
+
+// User registers saved on the user stack while a handler runs, sigreturn
+// puts them back
+typedef struct signal_context {
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+    uint32_t esi;
+    uint32_t edi;
+    uint32_t ebp;
+    uint32_t eax;
+    uint32_t eip;
+    uint32_t eflags;
+    uint32_t esp;
+} signal_context_t;
+
+struct pcb_t;
+struct syscall_frame;
+
+// Marks a signal pending, it is delivered when the process next returns to
+// user space. Wakes the process if it is blocked and the signal matters
+extern void signal_raise(struct pcb_t* pcb, uint32_t signum);
+
+// Nonzero when a pending signal has to end a sleep
+extern int32_t signal_interrupts(struct pcb_t* pcb);
+
+// Raises the signal for a user exception, FAILURE if it can't be handled
+extern int32_t signal_exception(struct pcb_t* pcb, uint32_t signum);
+
+// Raises a signal in the program running in the front of a terminal
+extern void signal_foreground(uint8_t terminal, uint32_t signum);
+
+// Raises ALARM in every process that handles it
+extern void signal_alarm();
+
+// Delivers pending signals on the way out of an interrupt or exception
+extern void signal_interrupt_exit(interrupt_frame_t* frame);
+
+// Delivers pending signals on the way out of a system call, returns ret
+extern int32_t signal_syscall_exit(struct syscall_frame* frame, int32_t ret);
+
+#endif
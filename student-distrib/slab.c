@@ -0,0 +1,184 @@
+#include "slab.h"
+
+// size classes kmalloc picks from, 16 bytes up to KMALLOC_MAX
+static kmem_cache_t kmalloc_caches[KMALLOC_CLASSES];
+static const char* kmalloc_names[KMALLOC_CLASSES] = {
+    "kmalloc-16", "kmalloc-32", "kmalloc-64", "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024", "kmalloc-2048"
+};
+
+static slab_t* slab_grow(kmem_cache_t* cache);
+static void slab_list_add(slab_t** list, slab_t* slab);
+static void slab_list_remove(slab_t** list, slab_t* slab);
+
+/* slab_init
+ * DESCRIPTION: Sets up the kmalloc size classes. Slabs are only taken from
+ *              the frame allocator once something is allocated
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void slab_init() {
+    uint32_t i;
+    for (i = 0; i < KMALLOC_CLASSES; i++) {
+        kmem_cache_init(&kmalloc_caches[i], kmalloc_names[i], 1 << (KMALLOC_MIN_SHIFT + i));
+    }
+}
+
+/* kmem_cache_init
+ * DESCRIPTION: Sets up an empty cache for objects of one size
+ * INPUTS: cache - cache to set up
+ *         name - name of the objects, for debugging
+ *         size - size of one object in bytes
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void kmem_cache_init(kmem_cache_t* cache, const char* name, uint32_t size) {
+    cache->name = name;
+    cache->size = (size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+    cache->per_slab = (FRAME_SIZE - SLAB_HEADER_SIZE) / cache->size;
+    cache->partial = NULL;
+    cache->full = NULL;
+    cache->slabs = 0;
+}
+
+/* kmem_cache_alloc
+ * DESCRIPTION: Pops the first free object of a partial slab, growing the
+ *              cache by one page when every slab is full
+ * INPUTS: cache - cache to allocate from
+ * OUTPUTS: the object, NULL when out of memory
+ * SIDE EFFECTS: May allocate a frame
+ */
+void* kmem_cache_alloc(kmem_cache_t* cache) {
+    uint32_t flags;
+    slab_t* slab;
+    void** obj;
+
+    cli_and_save(flags);
+    slab = cache->partial;
+    if (slab == NULL && (slab = slab_grow(cache)) == NULL) {
+        restore_flags(flags);
+        return NULL;
+    }
+    obj = (void**)slab->free;
+    slab->free = *obj;
+    slab->in_use++;
+    if (slab->free == NULL) {
+        slab_list_remove(&cache->partial, slab);
+        slab_list_add(&cache->full, slab);
+    }
+    restore_flags(flags);
+    return obj;
+}
+
+/* kmem_cache_free
+ * DESCRIPTION: Pushes an object back on its slab's free list. The slab is
+ *              found by rounding the object down to its page, and an empty
+ *              slab goes back to the frame allocator unless it is the only
+ *              one left with room
+ * INPUTS: obj - object from kmem_cache_alloc, NULL is ignored
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: May free a frame
+ */
+void kmem_cache_free(void* obj) {
+    uint32_t flags;
+    slab_t* slab;
+    kmem_cache_t* cache;
+    if (obj == NULL) { return; }
+
+    cli_and_save(flags);
+    slab = (slab_t*)((uint32_t)obj & SLAB_MASK);
+    cache = slab->cache;
+    if (slab->free == NULL) {
+        slab_list_remove(&cache->full, slab);
+        slab_list_add(&cache->partial, slab);
+    }
+    *(void**)obj = slab->free;
+    slab->free = obj;
+    slab->in_use--;
+    if (slab->in_use == 0 && (slab->next != NULL || slab->prev != NULL)) {
+        slab_list_remove(&cache->partial, slab);
+        cache->slabs--;
+        frame_free((uint32_t)slab, 0);
+    }
+    restore_flags(flags);
+}
+
+/* kmalloc
+ * DESCRIPTION: Allocates from the smallest size class the request fits in
+ * INPUTS: size - bytes wanted
+ * OUTPUTS: the memory, NULL when out of memory or larger than KMALLOC_MAX
+ * SIDE EFFECTS: May allocate a frame
+ */
+void* kmalloc(uint32_t size) {
+    uint32_t i;
+    for (i = 0; i < KMALLOC_CLASSES; i++) {
+        if (size <= (1 << (KMALLOC_MIN_SHIFT + i))) { return kmem_cache_alloc(&kmalloc_caches[i]); }
+    }
+    return NULL;
+}
+
+/* kfree
+ * DESCRIPTION: Frees memory from kmalloc
+ * INPUTS: ptr - memory to free, NULL is ignored
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: May free a frame
+ */
+void kfree(void* ptr) {
+    kmem_cache_free(ptr);
+}
+
+/* slab_grow
+ * DESCRIPTION: Takes a page from the frame allocator and threads every
+ *              object in it onto the free list, lowest address first
+ * INPUTS: cache - cache that ran out of free objects
+ * OUTPUTS: the new slab, NULL when out of memory
+ * SIDE EFFECTS: Puts the slab on the cache's partial list
+ */
+static slab_t* slab_grow(kmem_cache_t* cache) {
+    uint32_t i;
+    uint8_t* obj;
+    slab_t* slab;
+    if (cache->per_slab == 0 || (slab = (slab_t*)frame_alloc(0)) == NULL) { return NULL; }
+
+    slab->cache = cache;
+    slab->free = NULL;
+    slab->in_use = 0;
+    obj = (uint8_t*)slab + SLAB_HEADER_SIZE + (cache->per_slab - 1) * cache->size;
+    for (i = 0; i < cache->per_slab; i++, obj -= cache->size) {
+        *(void**)obj = slab->free;
+        slab->free = obj;
+    }
+    slab_list_add(&cache->partial, slab);
+    cache->slabs++;
+    return slab;
+}
+
+/* slab_list_add
+ * DESCRIPTION: Puts a slab at the front of a list
+ * INPUTS: list - head of the list
+ *         slab - slab to add
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void slab_list_add(slab_t** list, slab_t* slab) {
+    slab->prev = NULL;
+    slab->next = *list;
+    if (slab->next != NULL) { slab->next->prev = slab; }
+    *list = slab;
+}
+
+/* slab_list_remove
+ * DESCRIPTION: Unlinks a slab from a list
+ * INPUTS: list - head of the list
+ *         slab - slab to remove
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void slab_list_remove(slab_t** list, slab_t* slab) {
+    if (slab->prev != NULL) { slab->prev->next = slab->next; }
+    else { *list = slab->next; }
+    if (slab->next != NULL) { slab->next->prev = slab->prev; }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
@@ -0,0 +1,59 @@
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include "types.h"
+#include "lib.h"
+#include "frame_alloc.h"
+
+#define SLAB_ALIGN          8                   // objects start on 8 byte boundaries
+#define SLAB_MASK           (~(FRAME_SIZE - 1)) // finds the slab an object lives in
+#define KMALLOC_MIN_SHIFT   4                   // smallest size class is 16 bytes
+#define KMALLOC_CLASSES     8                   // 16 bytes up to 2KB
+#define KMALLOC_MAX         (1 << (KMALLOC_MIN_SHIFT + KMALLOC_CLASSES - 1))
+
+/* testing constants */
+#define SLAB_BENCH_OBJECTS  512
+#define SLAB_BENCH_SIZE     64
+
+struct kmem_cache;
+
+// Header at the start of every slab page, the objects follow it
+typedef struct slab {
+    struct kmem_cache* cache;   // cache the slab belongs to
+    struct slab* next;          // neighbours on the cache's partial or full list
+    struct slab* prev;
+    void* free;                 // first free object, linked through the objects
+    uint32_t in_use;            // objects handed out
+} slab_t;
+
+#define SLAB_HEADER_SIZE    ((sizeof(slab_t) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1))
+
+// A cache of equally sized objects, carved out of one page slabs
+typedef struct kmem_cache {
+    const char* name;
+    uint32_t size;              // object size rounded up to SLAB_ALIGN
+    uint32_t per_slab;          // objects that fit after the header
+    slab_t* partial;            // slabs with at least one free object
+    slab_t* full;               // slabs with none
+    uint32_t slabs;             // pages the cache holds
+} kmem_cache_t;
+
+// Sets up the kmalloc size classes
+extern void slab_init();
+
+// Sets up a cache for objects of one type
+extern void kmem_cache_init(kmem_cache_t* cache, const char* name, uint32_t size);
+
+// Takes an object from a cache, NULL when out of memory
+extern void* kmem_cache_alloc(kmem_cache_t* cache);
+
+// Gives an object back to the cache it came from
+extern void kmem_cache_free(void* obj);
+
+// Allocates from the smallest size class that fits, NULL above KMALLOC_MAX
+extern void* kmalloc(uint32_t size);
+
+// Frees memory from kmalloc
+extern void kfree(void* ptr);
+
+#endif
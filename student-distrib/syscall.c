@@ -1,10 +1,16 @@
 #include "syscall.h"
+#include "scheduler.h"
+#include "pipe.h"
+#include "timer.h"
+#include "pit.h"
+#include "console.h"
 
 #define FD_MAX 7
 
-// Status of all processes
-uint8_t avail_processes[MAX_PROCESSES] = {0, 0, 0, 0, 0, 0};
 
+static pcb_t* load_program(const uint8_t* command, int32_t process_num, uint32_t* eip);
+static void exit_detached(pcb_t* pcb, uint8_t status);
+static void sleep_wake(void* data);
 
 // Operations tables for PCB
 int32_t (*rtc_operations_table[NUM_OF_OPERATIONS])() = {rtc_read, rtc_write, rtc_open, rtc_close};
@@ -23,17 +29,38 @@ int32_t halt(uint8_t status) {
     // clear interrupts
     cli();
     
-    // find current process
+    // find current process, there is none while the kernel idles
     pcb_t* current_pcb = find_pcb();
+    if (current_pcb == NULL) {
+        sti();
+        return FAILURE;
+    }
+
+    // its own forked and spawned children can't be waited for anymore
+    scheduler_orphan(current_pcb);
+
+    // nobody waits in execute for a forked or spawned process
+    if (current_pcb->detached) {
+        exit_detached(current_pcb, status);
+        return FAILURE;
+    }
 
     // get parent process pointer to current process
     pcb_t* parent_pcb = current_pcb->parent_pcb;
     current_pcb->parent_pcb = NULL;
 
+    // close any files that may be open, a restarted shell gets a fresh pcb
+    // and would leak its pipes and rtc clock otherwise
+    int32_t i;
+    for(i = START; i < MAX_NUM_OF_FILES; i++) {
+        if(current_pcb->file_array[i].flags == OCCUPIED) {close(i);}
+    }
+
     // restarts shell if halt is called in the initial shell execution
     if (parent_pcb == NULL) {
         // frees up available process
-        avail_processes[current_pcb->process_id] = AVAILABLE; 
+        pid_release(current_pcb->process_id);
+        run_queue_remove(current_pcb);
         set_pcb((pcb_t*)0x0);
         execute((uint8_t*)"shell");
 
@@ -44,39 +71,29 @@ int32_t halt(uint8_t status) {
     parent_pcb->child_pcb = NULL; 
     
     // free up current pcb's process in array of available processes
-    avail_processes[(uint8_t)current_pcb->process_id] = AVAILABLE;
-
-    // close any files that may be open
-    int32_t i;
-    for(i = START; i < MAX_NUM_OF_FILES; i++) {
-        if(current_pcb->file_array[i].flags == OCCUPIED) {close(i);}
-    }
+    pid_release(current_pcb->process_id);
     
     current_pcb->args[0] = '\0';
 
     // set certain pcb fields to appropriate "unused" values
     set_pcb(parent_pcb);
 
-    // reverse program paging
-    uint32_t* program_page = get_page_directory(PROG_PAGE_IDX);
-    uint32_t prog_mem = PHYS_PAGE_START + (PROGRAM_SIZE*parent_pcb->process_id);
-    *program_page = 0x00000000; // Clear the page just in case
-    *program_page = prog_mem | FLAG_P | FLAG_RW | FLAG_US | FLAG_PS;
-  
+    // parent was blocked in execute, it continues in place of the child
+    run_queue_remove(current_pcb);
+    parent_pcb->state = PROCESS_RUNNABLE;
+    run_queue_add(parent_pcb);
+
     *get_vidmem_entry(current_pcb->process_id) = 0x00000000;
 
-    // flush tlb
-    asm volatile (
-        "mov %%cr3, %%eax;"
-        "mov %%eax, %%cr3;"
-        :
-        :
-        : "%eax"
-    );
+    // release the program's pages and shared text
+    reset_process_pages(current_pcb->process_id);
+
+    // reverse program paging and flush tlb
+    map_process_pages(parent_pcb->process_id);
 
     // set ss0 and esp0 in tss
     tss.ss0 = KERNEL_DS;
-    tss.esp0 = PHYS_PAGE_START - (parent_pcb->process_id * PROG_STACK_SIZE) - LONG;
+    tss.esp0 = pcb_stack_top(parent_pcb);
 
     // restore interrupts
     sti();
@@ -100,15 +117,70 @@ int32_t execute(const uint8_t* command) {
     if (command == NULL) { return FAILURE; } //returns -1 for incorrect commands
     else if (command[0] == '\0') { return FAILURE; }
     
-    // Check if there are open processes
-    uint8_t process_num = 0;
-    for (process_num = 0; process_num < MAX_PROCESSES; process_num++) {
-        if (avail_processes[process_num] == 0) { break; } 
-        // If we've found no available process, return failure
-        else if (process_num == MAX_PROCESSES-1) { return FAILURE; }
+    // Check if there are open processes. A terminal's first shell keeps the
+    // number whose block its kernel stack lives in
+    cli();
+    int32_t process_num = next_available_process();
+    if (find_pcb() == NULL && terminal_process_nums[cur_scheduled_terminal] != NOT_ASSIGNED) {
+        process_num = terminal_process_nums[cur_scheduled_terminal];
     }
+    if (process_num == FAILURE) {
+        sti();
+        return FAILURE;
+    }
+    
+    // Load the program, this fails when there is no memory left for it
+    uint32_t eip;
+    pcb_t* new_pcb = load_program(command, process_num, &eip);
+    if (new_pcb == NULL) {
+        sti();
+        return FAILURE;
+    }
+    map_process_pages(process_num);
+
+    // Create the PCB
+    set_pcb(new_pcb);
+    pid_claim(process_num);    // Claim the process
+
+    // The parent sleeps in execute until the child halts
+    if (new_pcb->parent_pcb != NULL) {
+        new_pcb->parent_pcb->state = PROCESS_BLOCKED;
+        run_queue_remove(new_pcb->parent_pcb);
+    }
+    new_pcb->state = PROCESS_RUNNABLE;
+    run_queue_add(new_pcb);
+    
+    // Context Switch
+    // ss0 will contain the location of the Kernel Data Segment
+    tss.ss0 =  KERNEL_DS;
+    // esp0 will point to the new stack pointer
+    tss.esp0 = pcb_stack_top(new_pcb);
+    
+    sti();
+    
+    uint32_t result = execute_context_switch(eip); //calls context switch
+
+    // The child has halted, give its memory back unless a process started
+    // since then has already taken its number
     cli();
+    if (!pid_in_use(process_num)) { pcb_free(process_num); }
+    sti();
     
+    return result;
+}
+
+/*
+ * pcb_t* load_program(const uint8_t* command, int32_t process_num, uint32_t* eip)
+ * DESCRIPTION: Parses a command, sets up a pcb for it under the given
+ *              process number and prepares its (still empty) address
+ *              space. Shared by execute and spawn
+ * INPUTS: command = the file system command to be executed
+ *         process_num = free process number for the program
+ *         eip = where the program's entry point is written
+ * OUTPUTS: the new pcb, NULL if the program can't be loaded
+ * SIDE EFFECTS: Links the pcb below the current process like execute does
+ */
+static pcb_t* load_program(const uint8_t* command, int32_t process_num, uint32_t* eip) {
     dentry_t dentry_ref;
     dentry_t* dentry = &dentry_ref;
     // Parse command
@@ -127,8 +199,9 @@ int32_t execute(const uint8_t* command) {
     }
 
 
-    // Create the PCB
+    // Create the PCB, this fails when there is no memory left for it
     pcb_t* new_pcb = pcb_init(command_str, 0x0, process_num);
+    if (new_pcb == NULL) { return NULL; }
 
     int32_t counter;
     if (command[i] != '\n') { //parses out the argument for certain function calls such as cat
@@ -143,68 +216,33 @@ int32_t execute(const uint8_t* command) {
     }
 
     if (read_dentry_by_name(command_str, &dentry_ref) == FAILURE) { //checks for failure from read_dentry_by_name
-        new_pcb->parent_pcb->child_pcb = NULL;
-        sti();
-        return FAILURE;
+        if (new_pcb->parent_pcb != NULL) { new_pcb->parent_pcb->child_pcb = NULL; }
+        return NULL;
     }
    
     // Acquire program data
     uint8_t data_buf[FILE_METADATA];
     if (read_data(dentry->inode_num, 0x0, data_buf, FILE_METADATA) == FAILURE) {
-	    new_pcb->parent_pcb->child_pcb = NULL;
-        sti();
-        return FAILURE;
+	    if (new_pcb->parent_pcb != NULL) { new_pcb->parent_pcb->child_pcb = NULL; }
+        return NULL;
     }
 
     // Executable Check
     if (data_buf[0] != ELF_MAG0 || data_buf[1] != ELF_MAG1
         || data_buf[2] != ELF_MAG2 || data_buf[3] != ELF_MAG3) {
-        new_pcb->parent_pcb->child_pcb = NULL;
-        sti();
-        return FAILURE;
+        if (new_pcb->parent_pcb != NULL) { new_pcb->parent_pcb->child_pcb = NULL; }
+        return NULL;
     }
  
-    // Set up Program paging
-    uint32_t* program_page = get_page_directory(PROG_PAGE_IDX);
-    uint32_t old_page = *program_page;
-    uint32_t prog_mem = PHYS_PAGE_START + (PROGRAM_SIZE*process_num);
-    *program_page = 0x00000000; // Clear the page just in case
-    *program_page = prog_mem | FLAG_P | FLAG_RW | FLAG_US | FLAG_PS;
-    
-    // Flush the TLB
-    asm volatile (
-        "mov %%cr3, %%eax;"
-        "mov %%eax, %%cr3;"
-        :
-        :
-        :"%eax"
-    );
-
-    // User-level program loader
-    if (read_data(dentry->inode_num, 0x0, (uint8_t*)(PROG_CODE_START), FOUR_MB) == FAILURE) {
-        *program_page = old_page;
-        new_pcb->parent_pcb->child_pcb = NULL;
-        sti();
-        // CLEAR THE PCB STUFF AS WELL
-        return FAILURE;
-    }
-
-    // Create the PCB
-    set_pcb(new_pcb);
-    avail_processes[process_num] = OCCUPIED;    // Claim the process  
-    
-    // Context Switch
-    // ss0 will contain the location of the Kernel Data Segment
-    tss.ss0 =  KERNEL_DS;
-    // esp0 will point to the new stack pointer
-    tss.esp0 = PHYS_PAGE_START - (process_num * PROG_STACK_SIZE) - LONG;
-    
-    sti();
-    
-    uint32_t eip = ((uint32_t*)(data_buf))[PROG_ENTRY_IDX];
-    uint32_t result = execute_context_switch(eip); //calls context switch
-    
-    return result;
+    // Set up Program paging. Nothing is copied here, the page fault handler
+    // loads each page of the executable the first time it is touched
+    reset_process_pages(process_num);
+    new_pcb->exe_inode = dentry->inode_num;
+    new_pcb->exe_length = file_length(dentry->inode_num);
+    share_program_text(process_num, new_pcb->exe_inode, new_pcb->exe_length);
+
+    *eip = ((uint32_t*)(data_buf))[PROG_ENTRY_IDX];
+    return new_pcb;
 }
 
 
@@ -281,6 +319,7 @@ int32_t open(const uint8_t* filename) {
         else if(pcb->file_array[fd].flags == AVAILABLE) {
             pcb->file_array[fd].flags = OCCUPIED;
             pcb->file_array[fd].file_position = START;
+            pcb->file_array[fd].object = NULL;
             break;
         }
     }
@@ -331,20 +370,23 @@ int32_t close(int32_t fd) {
     pcb_t* pcb;
     pcb = find_pcb();
 
-     // if there is no file to close, return failure
-    if(pcb->file_array[fd].flags == AVAILABLE) {
-            
+    // if file descriptor is not within range of valid file indices, return failure
+    if((fd < MIN_NUM_OF_FILES) || (fd >= MAX_NUM_OF_FILES)) {
+        
         return FAILURE;
 
     }
 
-    // if file descriptor is not within range of valid file indices, return failure
-    if((fd < MIN_NUM_OF_FILES) || (fd > MAX_NUM_OF_FILES)) {
-        
+     // if there is no file to close, return failure
+    if(pcb->file_array[fd].flags == AVAILABLE) {
+            
         return FAILURE;
 
     }
 
+    // let the file release what it holds, a pipe end may free its pipe
+    pcb->file_array[fd].operations_table[CLOSE](fd);
+
     // update items in file entry
     for(i = START; i < NUM_OF_OPERATIONS; i++) {
 
@@ -354,13 +396,6 @@ int32_t close(int32_t fd) {
     pcb->file_array[fd].inode = NONE;
     pcb->file_array[fd].file_position = NONE;
     pcb->file_array[fd].flags = AVAILABLE;
-    
-    // if closing the file properly is not successful, return failure
-    /*if(pcb->file_array[fd].operations_table[CLOSE](fd) != SUCCESS) {
-        
-        return FAILURE;
-
-    }*/
 
     // return success
     return SUCCESS;
@@ -389,7 +424,8 @@ int32_t getargs(uint8_t* buf, int32_t nbytes) {
 
 /*
 FUNCTION NAME: vidmap
-DESCRIPTION:   Maps a 4KB page to video memory so user-programs can use it
+DESCRIPTION:   Maps a 4KB page to the video memory of the caller's terminal
+               so user-programs can use it
 INPUTS:        screen_start - pointer to pointer which user wants to be set
                               to video memory
 OUTPUTS:       screen_start - Will point to base addres of page which is set to
@@ -403,11 +439,12 @@ int32_t vidmap(uint8_t** screen_start) {
     
     // every process has its' own page for video memory
     uint32_t table_idx = find_pcb()->process_id;
+    uint8_t terminal = find_pcb()->terminal;
     uint32_t* table = get_vidmem_entry(table_idx);
     
     // clear table entry, then set the appropriate flags and memory location
     *table = 0x00000000;
-    *table = VIDEO_MEMORY | FLAG_P | FLAG_RW | FLAG_US;
+    *table = CONSOLE_REGION(terminal) | FLAG_P | FLAG_RW | FLAG_US;
     
     // flush the tlb
     asm volatile (
@@ -418,6 +455,10 @@ int32_t vidmap(uint8_t** screen_start) {
         :"%eax"
     );
     
+    // the page is the start of the terminal's region, so the screen has to
+    // be there. It stays the terminal's whether or not it is shown
+    console_home(terminal);
+
     // set the screen_start pointer to point at the beginning of the page
     *screen_start = (uint8_t*)(VIDMEM_DIR_IDX * FOUR_MB + table_idx * FOUR_KB);
     
@@ -426,35 +467,392 @@ int32_t vidmap(uint8_t** screen_start) {
 
 /*
 FUNCTION NAME: set_handler
-DESCRIPTION:   sets handler
-INPUTS:        signum
-			handler_address
-OUTPUTS:       none
+DESCRIPTION:   sets the user function that runs when a signal is delivered
+               to the calling process
+INPUTS:        signum - signal number
+			handler_address - handler in the program page, NULL for the
+			                  default action
+OUTPUTS:       returns 0 upon success or -1 upon failure
 SIDE EFFECTS:  none
 */
 int32_t set_handler(int32_t signum, void* handler_address) {
-    return FAILURE;
+    if (signum < 0 || signum >= NUM_SIGNALS) { return FAILURE; }
+    if (handler_address != NULL && ((uint32_t)handler_address < VIRT_PAGE_START ||
+        (uint32_t)handler_address >= VIRT_PAGE_START + PROGRAM_SIZE)) { return FAILURE; }
+    find_pcb()->signal_handlers[signum] = handler_address;
+    return SUCCESS;
 }
 
 /*
 FUNCTION NAME: sigreturn
-DESCRIPTION:   returns signal
+DESCRIPTION:   made by the linkage code a handler returns into. The user
+               registers signal_setup saved above the signal number are put
+               back in the syscall frame, so the program continues where the
+               signal stopped it
 INPUTS:        none
-OUTPUTS:       none
-SIDE EFFECTS:  none
+OUTPUTS:       the saved eax, so it survives the return, or -1 for failure
+SIDE EFFECTS:  unmasks signals
 */
 int32_t sigreturn(void) {
-    return FAILURE;
+    pcb_t* pcb = find_pcb();
+    syscall_frame_t* frame = get_syscall_frame(pcb);
+
+    // the handler's ret popped the return address, the signal number is next
+    signal_context_t* context = (signal_context_t*)(frame->esp + LONG);
+    if ((uint32_t)context < VIRT_PAGE_START || (uint32_t)(context + 1) > VIRT_PAGE_START + PROGRAM_SIZE) { return FAILURE; }
+
+    frame->ebx = context->ebx;
+    frame->ecx = context->ecx;
+    frame->edx = context->edx;
+    frame->esi = context->esi;
+    frame->edi = context->edi;
+    frame->ebp = context->ebp;
+    frame->eip = context->eip;
+    frame->esp = context->esp;
+    frame->eflags = (frame->eflags & ~EFLAGS_USER) | (context->eflags & EFLAGS_USER);
+    pcb->signals_masked = 0;
+    return context->eax;
 }
 
-// Returns the next available process, if any
-int8_t next_available_process() {
-    uint8_t process_num;
-    for (process_num = 0; process_num < MAX_PROCESSES; process_num++) {
-        if (avail_processes[process_num] == 0) { return process_num; } 
-        // If we've found no available process, return failure
+/*
+FUNCTION NAME: mmap
+DESCRIPTION:   Maps an open file's data blocks read-only into the mmap region
+               of the calling process. The blocks are mapped where they sit
+               in the filesystem image, so no data is copied
+INPUTS:        fd - file descriptor of an open regular file
+               start - pointer which will be set to the start of the mapping
+OUTPUTS:       length of the file in bytes, or -1 for failure
+SIDE EFFECTS:  Uses up 4KB pages of the 136-140 MB virtual addresses
+*/
+int32_t mmap(int32_t fd, uint8_t** start) {
+    if (fd < MIN_NUM_OF_FILES || fd > FD_MAX) { return FAILURE; }
+
+    // only allow if the pointer is within the program page
+    if ((uint32_t)start < VIRT_PAGE_START || (uint32_t)start > VIRT_PAGE_START + PROGRAM_SIZE - LONG) { return FAILURE; }
+
+    // only regular files have data blocks to map
+    pcb_t* pcb = find_pcb();
+    fentry_t* file = &(pcb->file_array[fd]);
+    if (file->flags == AVAILABLE || file->operations_table[READ] != file_read) { return FAILURE; }
+    int32_t length = file_length(file->inode);
+    if (length == FAILURE) { return FAILURE; }
+
+    // map right after the last mapping, entries go from non-present to present so no flush is needed
+    uint32_t* table = get_mmap_table(pcb->process_id);
+    int32_t pages = map_file_pages(file->inode, table + pcb->mmap_pages, NUM_OF_ENTRIES - pcb->mmap_pages);
+    if (pages == FAILURE) { return FAILURE; }
+
+    *start = (uint8_t*)(MMAP_DIR_IDX * FOUR_MB + pcb->mmap_pages * FOUR_KB);
+    pcb->mmap_pages += pages;
+    return length;
+}
+
+/*
+FUNCTION NAME: fork
+DESCRIPTION:   creates a copy of the calling process. The child shares every
+               page with the parent copy-on-write and gets a copy of its file
+               array, so nothing is read from the file system and only pages
+               one of them writes are ever copied. The parent's vidmap page
+               is mapped in the child's own video slot too, so the child
+               has video memory without calling vidmap. The pointer it
+               inherited names the parent's slot, which works while the
+               parent runs. The child returns from the same int $0x80 with
+               0 in eax
+INPUTS:        none
+OUTPUTS:       the child's process number to the parent, -1 on failure
+SIDE EFFECTS:  puts the child on the run queue
+*/
+int32_t fork(void) {
+    int i;
+    cli();
+    pcb_t* parent = find_pcb();
+    int32_t process_num = next_available_process();
+    if (parent == NULL || process_num == FAILURE) {
+        sti();
+        return FAILURE;
     }
-    // If we don't find an available process, we've failed
-    return FAILURE;
 
+    // pcb_init hangs the new pcb below the caller the way execute wants it,
+    // but a forked child is not part of the caller's execute chain
+    pcb_t* chain = parent->child_pcb;
+    pcb_t* child = pcb_init(parent->args, 0x0, process_num);
+    parent->child_pcb = chain;
+    if (child == NULL) {
+        sti();
+        return FAILURE;
+    }
+    child->parent_pcb = NULL;
+    child->detached = 1;
+    child->owner = parent;
+    memcpy(child->args, parent->args, MAX_ARGS);
+    memcpy(child->file_array, parent->file_array, MAX_NUM_OF_FILES * sizeof(fentry_t));
+    for (i = MIN_NUM_OF_FILES; i < MAX_NUM_OF_FILES; i++) {
+        pipe_dup(&child->file_array[i]);
+        rtc_dup(&child->file_array[i]);
+    }
+    memcpy(child->signal_handlers, parent->signal_handlers, sizeof(parent->signal_handlers));
+    child->signals_masked = parent->signals_masked;
+    child->exe_inode = parent->exe_inode;
+    child->exe_length = parent->exe_length;
+    reset_process_pages(process_num);
+    copy_process_pages(parent->process_id, process_num);
+
+    // video pages are shared between processes, one slot per process number
+    if (*get_vidmem_entry(parent->process_id) & FLAG_P) {
+        *get_vidmem_entry(process_num) = *get_vidmem_entry(parent->process_id);
+    }
+
+    // the child resumes on its own stack with a copy of the parent's registers
+    syscall_frame_t* frame = get_syscall_frame(child);
+    *frame = *get_syscall_frame(parent);
+    child->context_esp = scheduler_new_context((uint32_t)frame, fork_return);
+
+    pid_claim(process_num);
+    child->state = PROCESS_RUNNABLE;
+    run_queue_add(child);
+    sti();
+    return process_num;
+}
+
+/*
+FUNCTION NAME: spawn
+DESCRIPTION:   starts a program in the background. It is loaded like execute
+               loads it, but the caller keeps running and gets the child's
+               process number back, to collect it later with wait
+INPUTS:        command - program and arguments, as for execute
+OUTPUTS:       the child's process number, -1 on failure
+SIDE EFFECTS:  puts the child on the run queue
+*/
+int32_t spawn(const uint8_t* command) {
+    uint32_t eip;
+    if (command == NULL || command[0] == '\0') { return FAILURE; }
+    cli();
+    pcb_t* parent = find_pcb();
+    int32_t process_num = next_available_process();
+    if (parent == NULL || process_num == FAILURE) {
+        sti();
+        return FAILURE;
+    }
+
+    // load_program hangs the child below the caller the way execute wants
+    // it, a background job is not part of the caller's execute chain
+    pcb_t* chain = parent->child_pcb;
+    pcb_t* child = load_program(command, process_num, &eip);
+    parent->child_pcb = chain;
+    if (child == NULL) {
+        sti();
+        return FAILURE;
+    }
+    child->parent_pcb = NULL;
+    child->detached = 1;
+    child->owner = parent;
+
+    // the child enters user space at the program's entry point through a
+    // syscall frame of its own, just like a forked child
+    syscall_frame_t* frame = get_syscall_frame(child);
+    memset(frame, 0, sizeof(syscall_frame_t));
+    frame->eip = eip;
+    frame->cs = USER_CS;
+    frame->eflags = EFLAGS_IF;
+    frame->esp = PROG_STACK_TOP;
+    frame->ss = USER_DS;
+    child->context_esp = scheduler_new_context((uint32_t)frame, fork_return);
+
+    pid_claim(process_num);
+    child->state = PROCESS_RUNNABLE;
+    run_queue_add(child);
+    sti();
+    return process_num;
+}
+
+/*
+FUNCTION NAME: wait
+DESCRIPTION:   sleeps until a child made by fork or spawn halts, then frees
+               what is left of it
+INPUTS:        pid - process number fork or spawn returned
+OUTPUTS:       the status the child passed to halt, -1 if pid is not a
+               running or halted child of the caller or a signal came first
+SIDE EFFECTS:  may block
+*/
+int32_t wait(int32_t pid) {
+    cli();
+    pcb_t* parent = find_pcb();
+    pcb_t* child = (pid >= 0) ? get_pcb(pid) : NULL;
+    if (parent == NULL || child == NULL || !pid_in_use(pid) || child->owner != parent) {
+        sti();
+        return FAILURE;
+    }
+    wait_event(&(parent->child_exit), child->state == PROCESS_ZOMBIE);
+    if (child->state != PROCESS_ZOMBIE) {
+        // a signal cut the wait short, the child can still be waited for
+        sti();
+        return FAILURE;
+    }
+
+    // the child switched away for the last time before this could run
+    int32_t status = child->exit_status;
+    pid_release(pid);
+    pcb_free(pid);
+    sti();
+    return status;
+}
+
+/*
+FUNCTION NAME: pipe
+DESCRIPTION:   creates a pipe and opens its two ends in the lowest free file
+               descriptors. Bytes written to fds[1] are read from fds[0], and
+               fork hands both ends to the child
+INPUTS:        fds - array of two descriptors to fill in
+OUTPUTS:       returns 0 upon success or -1 upon failure
+SIDE EFFECTS:  fds[0] gets the read end, fds[1] the write end
+*/
+int32_t pipe(int32_t* fds) {
+    int32_t fd, read_fd = FAILURE, write_fd = FAILURE;
+
+    // only allow if the array is within the program page
+    if ((uint32_t)fds < VIRT_PAGE_START || (uint32_t)(fds + 2) > VIRT_PAGE_START + PROGRAM_SIZE) { return FAILURE; }
+
+    pcb_t* pcb = find_pcb();
+    for (fd = MIN_NUM_OF_FILES; fd < MAX_NUM_OF_FILES && write_fd == FAILURE; fd++) {
+        if (pcb->file_array[fd].flags != AVAILABLE) { continue; }
+        if (read_fd == FAILURE) { read_fd = fd; }
+        else { write_fd = fd; }
+    }
+    if (write_fd == FAILURE) { return FAILURE; }
+    if (pipe_create(&pcb->file_array[read_fd], &pcb->file_array[write_fd]) == FAILURE) { return FAILURE; }
+
+    fds[0] = read_fd;
+    fds[1] = write_fd;
+    return SUCCESS;
+}
+
+/*
+FUNCTION NAME: sleep
+DESCRIPTION:   blocks the caller for at least ms milliseconds. A timer on
+               the wheel wakes it, so it is off the run queue until then
+               instead of waiting on the shared RTC rate
+INPUTS:        ms - milliseconds to sleep, rounded up to whole PIT ticks
+OUTPUTS:       returns 0 upon success or -1 upon failure, or when a signal
+               ends the sleep early
+SIDE EFFECTS:  blocks
+*/
+int32_t sleep(uint32_t ms) {
+    pcb_t* pcb = find_pcb();
+    if (pcb == NULL) { return FAILURE; }
+    if (ms == 0) { return SUCCESS; }
+
+    // one tick more, the current one is already partly over
+    uint32_t ticks = ms / MS_PER_SECOND * pit_hz + ((ms % MS_PER_SECOND) * pit_hz + MS_PER_SECOND - 1) / MS_PER_SECOND + 1;
+
+    cli();
+    timer_setup(&pcb->sleep_timer, sleep_wake, &pcb->sleep_queue);
+    timer_add(&pcb->sleep_timer, ticks);
+    wait_event(&pcb->sleep_queue, !pcb->sleep_timer.pending);
+    if (pcb->sleep_timer.pending) {
+        // a signal cut the sleep short
+        timer_del(&pcb->sleep_timer);
+        sti();
+        return FAILURE;
+    }
+    sti();
+    return SUCCESS;
+}
+
+/*
+FUNCTION NAME: set_quantum
+DESCRIPTION:   sets the time slice every process gets before the PIT
+               preempts it. Shorter slices mean more interrupts and less
+               time left for the programs
+INPUTS:        ms - slice length, PIT_MAX_HZ to PIT_MIN_HZ slices a second
+OUTPUTS:       returns 0 upon success or -1 upon failure
+SIDE EFFECTS:  changes the PIT rate
+*/
+int32_t set_quantum(uint32_t ms) {
+    if (ms == 0) { return FAILURE; }
+    return pit_set_hz(MS_PER_SECOND / ms);
+}
+
+/*
+FUNCTION NAME: profile
+DESCRIPTION:   controls the PIT sampling profiler. PROFILE_START clears the
+               histogram and starts sampling, PROFILE_STOP stops it,
+               PROFILE_READ copies the buckets into buf as profile_sample_t
+               and PROFILE_DUMP sends them over COM1
+INPUTS:        command - one of the PROFILE_ commands
+               buf - where PROFILE_READ puts the buckets
+               nbytes - size of buf
+OUTPUTS:       bytes copied for PROFILE_READ, otherwise 0 upon success or
+               -1 upon failure
+SIDE EFFECTS:  none
+*/
+int32_t profile(uint32_t command, void* buf, int32_t nbytes) {
+    switch (command) {
+        case PROFILE_STOP:
+            profile_stop();
+            return SUCCESS;
+        case PROFILE_START:
+            return profile_start();
+        case PROFILE_READ:
+            if (nbytes < 0 || (uint32_t)buf < VIRT_PAGE_START ||
+                (uint32_t)buf + nbytes > VIRT_PAGE_START + PROGRAM_SIZE) { return FAILURE; }
+            return profile_copy((profile_sample_t*)buf, nbytes / sizeof(profile_sample_t)) * sizeof(profile_sample_t);
+        case PROFILE_DUMP:
+            profile_dump();
+            return SUCCESS;
+        default:
+            return FAILURE;
+    }
+}
+
+/*
+FUNCTION NAME: sleep_wake
+DESCRIPTION:   timer function of sleep, runs in the PIT interrupt
+INPUTS:        data - sleep queue of the process
+OUTPUTS:       none
+SIDE EFFECTS:  puts the process back on the run queue
+*/
+static void sleep_wake(void* data) {
+    wait_queue_wake_all((wait_queue_t*)data);
+}
+
+/*
+FUNCTION NAME: exit_detached
+DESCRIPTION:   halt for a forked or spawned process. Its files and pages are
+               released right away, then it leaves the CPU for good. Its
+               owner or the scheduler frees the rest once it is off its
+               kernel stack
+INPUTS:        pcb - the current process
+               status - value for the owner's wait
+OUTPUTS:       none
+SIDE EFFECTS:  never returns
+*/
+static void exit_detached(pcb_t* pcb, uint8_t status) {
+    int32_t i;
+    for(i = START; i < MAX_NUM_OF_FILES; i++) {
+        if(pcb->file_array[i].flags == OCCUPIED) {close(i);}
+    }
+    *get_vidmem_entry(pcb->process_id) = 0x00000000;
+    pcb->exit_status = status;
+    run_queue_remove(pcb);
+    map_kernel_pages();
+    reset_process_pages(pcb->process_id);
+    scheduler_exit(pcb);
+}
+
+/*
+FUNCTION NAME: get_syscall_frame
+DESCRIPTION:   finds the user registers a process saved on its kernel stack
+               when it made its current system call
+INPUTS:        pcb - process in a system call
+OUTPUTS:       the process' syscall frame
+SIDE EFFECTS:  none
+*/
+syscall_frame_t* get_syscall_frame(pcb_t* pcb) {
+    // the processor starts pushing at tss.esp0, which is pcb_stack_top
+    return (syscall_frame_t*)pcb_stack_top(pcb) - 1;
+}
+
+// Returns the next available process, if any
+int32_t next_available_process() {
+    return pid_first_free();
 }
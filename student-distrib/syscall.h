@@ -57,9 +57,33 @@
 #define OPEN                2
 #define CLOSE               3
 
+#define EFLAGS_IF           0x200    // interrupt flag, set for user code
+#define PROG_STACK_TOP     (VIRT_PAGE_START + PROGRAM_SIZE - LONG)
+
 // Maximum number of processes in a single terminal
 #define PROCESS_CHAIN_MAX   4
 
+/* testing constants */
+#define FORK_BENCH_ROUNDS   100
+#define BACKGROUND_JOBS     4
+
+
+// User registers at the top of the kernel stack during a system call,
+// lowest address first. syscall_handle pushes ebx to ebp, the processor
+// pushes the rest
+typedef struct syscall_frame {
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+    uint32_t esi;
+    uint32_t edi;
+    uint32_t ebp;
+    uint32_t eip;
+    uint32_t cs;
+    uint32_t eflags;
+    uint32_t esp;
+    uint32_t ss;
+} syscall_frame_t;
 
 // system calls
 extern int32_t halt(uint8_t status);
@@ -72,8 +96,18 @@ extern int32_t getargs(uint8_t* buf, int32_t nbytes);
 extern int32_t vidmap(uint8_t** screen_start);
 extern int32_t set_handler(int32_t signum, void* handler_address);
 extern int32_t sigreturn(void);
+extern int32_t mmap(int32_t fd, uint8_t** start);
+extern int32_t fork(void);
+extern int32_t spawn(const uint8_t* command);
+extern int32_t wait(int32_t pid);
+extern int32_t pipe(int32_t* fds);
+extern int32_t sleep(uint32_t ms);
+extern int32_t set_quantum(uint32_t ms);
+extern int32_t profile(uint32_t command, void* buf, int32_t nbytes);
 
 // Helpers
-extern int8_t next_available_process();
+extern int32_t next_available_process();
+struct pcb_t;
+extern syscall_frame_t* get_syscall_frame(struct pcb_t* pcb);
 
 #endif
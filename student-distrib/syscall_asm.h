@@ -5,4 +5,6 @@ extern uint32_t execute_context_switch();
 
 extern uint32_t halt_return(uint8_t status, uint32_t ebp, uint32_t esp);
 
+extern void fork_return();
+
 #endif
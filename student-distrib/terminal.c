@@ -1,4 +1,6 @@
 #include "terminal.h"
+#include "scheduler.h"
+#include "console.h"
 
 /* int32_t terminal_open(const uint8_t* filename)
  * DESCRIPTION: opens up terminal driver for use by other functions
@@ -25,17 +27,18 @@ int32_t terminal_close(int32_t fd) {
 }
 
 /* int32_t terminal_read(int32_t fd,void* buf, int32_t nbytes))
- * DESCRIPTION: reads the input on the keyboard, only stops when enter is pressed
+ * DESCRIPTION: reads the input on the keyboard, blocks until enter is pressed
  * INPUT: 
  * fd - file directory for the terminal
  * buf- buffer to read from
  * nbytes- number of bytes to copy over to a copy buffer
- * OUTPUT: returns the number of characters typed
+ * OUTPUT: returns the number of characters typed, -1 if a signal came first
  * SIDE EFFECTS: Reads the terminal and copies it to a buffer
  */
 
 int32_t terminal_read(int32_t fd,void* buf, int32_t nbytes) {
-    while (!enter[cur_scheduled_terminal]) {} //continues reading until ENTER is pressed
+    wait_event(&enter_queue[cur_scheduled_terminal], enter[cur_scheduled_terminal]); //sleeps until ENTER is pressed
+    if (!enter[cur_scheduled_terminal]) {return -1;} //a signal woke it up first, the typed line stays in the buffer
 
     char* char_buf = (char*)buf;
     int size, i; //intializes the counter for reading
@@ -55,16 +58,16 @@ int32_t terminal_read(int32_t fd,void* buf, int32_t nbytes) {
  * buf- buffer to write from
  * nbytes- number of bytes to write
  * OUTPUT: returns the number of characters written
- * SIDE EFFECTS: Reads the terminal and writes it to screen
+ * SIDE EFFECTS: Reads the terminal and writes it to screen a run of
+ * characters at a time, the screen and cursor are updated once at the end
  */
 
 int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes) {
-    int counter;
-    char* char_buf = (char*) buf;
-    for (counter = 0; counter < nbytes; counter++) {
-	    putc(char_buf[counter]);
-    }
-    return counter;
+    if (nbytes <= 0) {return 0;}
+    console_write(cur_scheduled_terminal, (const uint8_t*)buf, nbytes, TERMINAL_FLAG ? ARRTIB : ATTRIB);
+    if (CURSOR) {consoles[cur_scheduled_terminal].cursor_moved = 1;} //cursor follows once for the whole write
+    console_flush(cur_scheduled_terminal);
+    return nbytes;
 }
 /* int32_t terminal_fail(fd, buf, nbytes)
  * DESCRIPTION: Returns failure if incorrect terminal is called
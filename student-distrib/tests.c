@@ -10,6 +10,17 @@
 #include "terminal.h"
 #include "filesys.h"
 #include "syscall.h"
+#include "page_cache.h"
+#include "scheduler.h"
+#include "wait_queue.h"
+#include "multi_term.h"
+#include "pit.h"
+#include "frame_alloc.h"
+#include "slab.h"
+#include "pipe.h"
+#include "timer.h"
+#include "config.h"
+#include "console.h"
 
 #define PASS 1
 #define FAIL 0
@@ -549,6 +560,1734 @@ int read_from_large_file(){
 	return result;
 }
 
+/* dentry_lookup_bench
+*
+* Times read_dentry_by_name for every name in the directory (hits) and
+* for names that are not in the image (misses)
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Prints cycles per lookup
+* Coverage: Hashed dentry index
+* Files: filesys.c
+*/
+int dentry_lookup_bench(){
+	TEST_HEADER;
+	int result = PASS;
+	uint8_t* misses[] = {(uint8_t*)"shel", (uint8_t*)"shells", (uint8_t*)"frame2.txt",
+	                     (uint8_t*)"verylargetextwithverylongname.txt", (uint8_t*)"nope"};
+	uint32_t num_misses = sizeof(misses) / sizeof(misses[0]);
+	uint8_t names[MAX_DENTRIES][FNAME_LEN + 1];
+	uint32_t num_names = 0;
+	uint32_t i, round, start, cycles;
+	dentry_t dentry;
+
+	/* collect every name through the index-based path */
+	for(i = 0; i < MAX_DENTRIES && read_dentry_by_index(i, &dentry) == 0; i++){
+		strncpy((int8_t*)names[num_names], (int8_t*)dentry.fname, FNAME_LEN);
+		names[num_names][FNAME_LEN] = '\0';
+		if(names[num_names][0] != '\0'){
+			num_names++;
+		}
+	}
+
+	start = rdtsc();
+	for(round = 0; round < LOOKUP_BENCH_ROUNDS; round++){
+		for(i = 0; i < num_names; i++){
+			if(read_dentry_by_name(names[i], &dentry) != 0){
+				result = FAIL;
+			}
+		}
+	}
+	cycles = rdtsc() - start;
+	printf("hits: %u lookups, %u cycles each\n", num_names * LOOKUP_BENCH_ROUNDS,
+	       cycles / (num_names * LOOKUP_BENCH_ROUNDS));
+
+	start = rdtsc();
+	for(round = 0; round < LOOKUP_BENCH_ROUNDS; round++){
+		for(i = 0; i < num_misses; i++){
+			if(read_dentry_by_name(misses[i], &dentry) == 0){
+				result = FAIL;
+			}
+		}
+	}
+	cycles = rdtsc() - start;
+	printf("misses: %u lookups, %u cycles each\n", num_misses * LOOKUP_BENCH_ROUNDS,
+	       cycles / (num_misses * LOOKUP_BENCH_ROUNDS));
+	return result;
+}
+
+/* read_data_chunk_test
+*
+* Reads every file whole and again in odd sized pieces that straddle
+* block and extent boundaries, and checks both reads agree
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: None
+* Coverage: Extent maps in read_data
+* Files: filesys.c
+*/
+int read_data_chunk_test(){
+	TEST_HEADER;
+	int result = PASS;
+	static uint8_t whole[BIG_BUF_SIZE];
+	static uint8_t pieces[BIG_BUF_SIZE];
+	uint32_t i, j, offset;
+	int32_t length, bytesR;
+	dentry_t dentry;
+	for(i = 0; i < MAX_DENTRIES && read_dentry_by_index(i, &dentry) == 0; i++){
+		if(dentry.ftype != FILE_TYPE || dentry.fname[0] == '\0'){
+			continue;
+		}
+		length = read_data(dentry.inode_num, 0, whole, BIG_BUF_SIZE);
+		if(length < 0){
+			return FAIL;
+		}
+		offset = 0;
+		while((bytesR = read_data(dentry.inode_num, offset, pieces + offset, ODD_CHUNK_SIZE)) > 0){
+			offset += bytesR;
+		}
+		if(offset != length){
+			result = FAIL;
+		}
+		for(j = 0; j < offset && j < length; j++){
+			if(whole[j] != pieces[j]){
+				result = FAIL;
+				break;
+			}
+		}
+		if(result == FAIL){
+			printf("   mismatch reading inode %d in pieces\n", dentry.inode_num);
+			return result;
+		}
+	}
+	return result;
+}
+
+/* mmap_read_bench
+*
+* Scans a large file through a read-style copy into a buffer and through
+* read-only mappings of its data blocks, and compares cycle counts
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Borrows the mmap table of process 0, prints cycles
+* Coverage: map_file_pages, mmap region paging
+* Files: filesys.c, paging.c
+*/
+int mmap_read_bench(){
+	TEST_HEADER;
+	static uint8_t buf[BIG_BUF_SIZE];
+	uint8_t* mapped = (uint8_t*)(MMAP_DIR_IDX * FOUR_MB);
+	uint32_t sum_read = 0, sum_map = 0;
+	uint32_t i, round, start, read_cycles, map_cycles;
+	int32_t length;
+	dentry_t dentry;
+	if(read_dentry_by_name((uint8_t*)"fish", &dentry) != 0){
+		return FAIL;
+	}
+	length = file_length(dentry.inode_num);
+
+	/* read(): copy the file into a buffer, then scan the buffer */
+	start = rdtsc();
+	for(round = 0; round < MMAP_BENCH_ROUNDS; round++){
+		read_data(dentry.inode_num, 0, buf, length);
+		for(i = 0; i < length; i++){
+			sum_read += buf[i];
+		}
+	}
+	read_cycles = rdtsc() - start;
+
+	/* mmap(): map the data blocks, then scan them in place. Tests run
+	 * before any process exists so process 0's tables are free */
+	set_pcb(NULL);
+	if(pcb_init((uint8_t*)"bench", 0x0, 0) == NULL) return FAIL;
+	memset(get_mmap_table(0), 0, FOUR_KB);
+	map_process_pages(0);
+	start = rdtsc();
+	for(round = 0; round < MMAP_BENCH_ROUNDS; round++){
+		if(map_file_pages(dentry.inode_num, get_mmap_table(0), NUM_OF_ENTRIES) <= 0){
+			return FAIL;
+		}
+		for(i = 0; i < length; i++){
+			sum_map += mapped[i];
+		}
+	}
+	map_cycles = rdtsc() - start;
+
+	printf("read: %u cycles/pass, mmap: %u cycles/pass, %d bytes\n",
+	       read_cycles / MMAP_BENCH_ROUNDS, map_cycles / MMAP_BENCH_ROUNDS, length);
+	return (sum_read == sum_map) ? PASS : FAIL;
+}
+
+/* exec_load_bench
+*
+* Compares the program loading cost of execute before and after demand
+* paging for a few programs. Before: the whole 4MB program page is filled
+* by read_data up front. After: the program tables are reset and only the
+* entry point page and the top of the stack get touched
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Borrows process 0's memory and a temporary pcb, prints cycles
+* Coverage: demand_page, exception_0E
+* Files: paging.c, exception.c, syscall.c
+*/
+int exec_load_bench(){
+	TEST_HEADER;
+	int8_t* programs[] = {"shell", "ls", "fish"};
+	uint32_t num_programs = sizeof(programs) / sizeof(programs[0]);
+	uint8_t header[ELF_HEADER_SIZE];
+	uint32_t i, start, eager, lazy, entry;
+	volatile uint8_t touch;
+	dentry_t dentry;
+	uint32_t image = frame_alloc(FRAME_MAX_ORDER);
+	pcb_t* pcb = pcb_init((uint8_t*)"bench", 0x0, 0);
+	if(image == 0 || pcb == NULL) return FAIL;
+	set_pcb(pcb);
+	for(i = 0; i < num_programs; i++){
+		if(read_dentry_by_name((uint8_t*)programs[i], &dentry) != 0){
+			set_pcb(NULL);
+			frame_free(image, FRAME_MAX_ORDER);
+			return FAIL;
+		}
+		read_data(dentry.inode_num, 0, header, ELF_HEADER_SIZE);
+		entry = ((uint32_t*)header)[PROG_ENTRY_IDX];
+
+		/* before: one 4MB page, whole image copied in with interrupts off */
+		*get_page_directory(PROG_PAGE_IDX) = image | FLAG_P | FLAG_RW | FLAG_US | FLAG_PS;
+		map_kernel_pages();
+		start = rdtsc();
+		read_data(dentry.inode_num, 0, (uint8_t*)PROG_CODE_START, FOUR_MB);
+		eager = rdtsc() - start;
+		*get_page_directory(PROG_PAGE_IDX) = FLAG_RW;
+
+		/* after: empty tables, the first instruction and push fault their pages in */
+		pcb->exe_inode = dentry.inode_num;
+		pcb->exe_length = file_length(dentry.inode_num);
+		start = rdtsc();
+		reset_process_pages(0);
+		map_process_pages(0);
+		touch = *(uint8_t*)entry;
+		*(uint8_t*)(VIRT_PAGE_START + PROGRAM_SIZE - LONG) = touch;
+		lazy = rdtsc() - start;
+
+		printf("%s: eager load %u cycles, demand paged start %u cycles\n", programs[i], eager, lazy);
+	}
+	reset_process_pages(0);
+	set_pcb(NULL);
+	frame_free(image, FRAME_MAX_ORDER);
+	return PASS;
+}
+
+/* process_table_stress_test
+*
+* Execs shell into new processes until the pid table or memory runs out.
+* Each one gets a pcb, paging structures, the shared text and a faulted in
+* stack page like a real exec. Then they all halt and are reaped
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Must run before the scheduler starts, prints throughput
+* Coverage: pid_first_free, pcb_alloc, pcb_free, demand_page
+* Files: pcb.c, syscall.c, paging.c
+*/
+int process_table_stress_test(){
+	TEST_HEADER;
+	uint32_t free_before = frame_free_count();
+	uint32_t count = 0, start, exec_cycles, halt_cycles, pid, flags;
+	int32_t next;
+	int out_of_memory = 0;
+	dentry_t dentry;
+	pcb_t* pcb;
+	if(read_dentry_by_name((uint8_t*)"shell", &dentry) != 0) return FAIL;
+	cli_and_save(flags);
+	set_pcb(NULL);
+
+	start = rdtsc();
+	while((next = next_available_process()) != FAILURE){
+		pcb = pcb_init((uint8_t*)"shell", 0x0, next);
+		if(pcb == NULL){
+			out_of_memory = 1;
+			break;
+		}
+		pcb->exe_inode = dentry.inode_num;
+		pcb->exe_length = file_length(dentry.inode_num);
+		reset_process_pages(next);
+		share_program_text(next, pcb->exe_inode, pcb->exe_length);
+		map_process_pages(next);
+		set_pcb(pcb);
+		pid_claim(next);
+		if(demand_page(VIRT_PAGE_START + PROGRAM_SIZE - LONG, PF_WRITE) == FAILURE){
+			out_of_memory = 1;
+			break;
+		}
+		count++;
+	}
+	exec_cycles = rdtsc() - start;
+	set_pcb(NULL);
+	map_kernel_pages();
+
+	start = rdtsc();
+	for(pid = 0; pid < max_processes; pid++){
+		if(!pid_in_use(pid)) continue;
+		pid_release(pid);
+		pcb_free(pid);
+	}
+	halt_cycles = rdtsc() - start;
+	restore_flags(flags);
+
+	if(count == 0) return FAIL;
+	printf("%u of %u processes before %s\n", count, max_processes, out_of_memory ? "running out of memory" : "the table filled");
+	printf("exec %u cycles, halt %u cycles per process\n", exec_cycles / count, halt_cycles / count);
+	/* the pcb and fd table caches may each keep one empty slab */
+	return (next_available_process() == 0 && frame_free_count() + 2 >= free_before) ? PASS : FAIL;
+}
+
+/* fork_bench
+*
+* Process 0 runs shell with its entry page and a written stack page. Each
+* round makes process 1 the way execute would (read the header, map the
+* cached text, fault in the entry and stack pages) or the way fork would
+* (share every page copy-on-write, copy the stack page on the child's
+* write), then halts it again. Also checks the child's write doesn't
+* reach the parent
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Borrows processes 0 and 1, prints cycles per round
+* Coverage: copy_process_pages, demand_page, frame_put
+* Files: paging.c, frame_alloc.c, syscall.c
+*/
+int fork_bench(){
+	TEST_HEADER;
+	uint32_t stack_idx = NUM_OF_ENTRIES - 1;
+	uint32_t round, start, exec_cycles = 0, fork_cycles = 0, flags;
+	volatile uint8_t* stack = (uint8_t*)(VIRT_PAGE_START + PROGRAM_SIZE - LONG);
+	volatile uint8_t touch;
+	uint8_t header[ELF_HEADER_SIZE];
+	dentry_t dentry;
+	int result = PASS;
+	pcb_t* child;
+	if(read_dentry_by_name((uint8_t*)"shell", &dentry) != 0) return FAIL;
+	cli_and_save(flags);
+	set_pcb(NULL);
+	pcb_t* parent = pcb_init((uint8_t*)"shell", 0x0, 0);
+	if(parent == NULL) return FAIL;
+	parent->exe_inode = dentry.inode_num;
+	parent->exe_length = file_length(dentry.inode_num);
+	reset_process_pages(0);
+	share_program_text(0, parent->exe_inode, parent->exe_length);
+	map_process_pages(0);
+	set_pcb(parent);
+	read_data(dentry.inode_num, 0, header, ELF_HEADER_SIZE);
+	touch = *(uint8_t*)(((uint32_t*)header)[PROG_ENTRY_IDX]);
+	*stack = 1;
+
+	for(round = 0; round < FORK_BENCH_ROUNDS; round++){
+		/* before: execute and halt */
+		start = rdtsc();
+		set_pcb(NULL);
+		child = pcb_init((uint8_t*)"shell", 0x0, 1);
+		read_dentry_by_name((uint8_t*)"shell", &dentry);
+		read_data(dentry.inode_num, 0, header, ELF_HEADER_SIZE);
+		child->exe_inode = dentry.inode_num;
+		child->exe_length = file_length(dentry.inode_num);
+		reset_process_pages(1);
+		share_program_text(1, child->exe_inode, child->exe_length);
+		map_process_pages(1);
+		set_pcb(child);
+		touch = *(uint8_t*)(((uint32_t*)header)[PROG_ENTRY_IDX]);
+		*stack = touch;
+		map_process_pages(0);
+		set_pcb(parent);
+		pcb_free(1);
+		exec_cycles += rdtsc() - start;
+
+		/* after: fork and exit */
+		start = rdtsc();
+		set_pcb(NULL);
+		child = pcb_init((uint8_t*)"shell", 0x0, 1);
+		child->exe_inode = parent->exe_inode;
+		child->exe_length = parent->exe_length;
+		reset_process_pages(1);
+		copy_process_pages(0, 1);
+		if(round == 0 && (!(get_program_table(0)[stack_idx] & FLAG_COW) || get_program_table(1)[stack_idx] != get_program_table(0)[stack_idx])) result = FAIL;
+		map_process_pages(1);
+		set_pcb(child);
+		*stack = 2;
+		map_process_pages(0);
+		set_pcb(parent);
+		if(*stack != 1) result = FAIL;
+		pcb_free(1);
+		*stack = 1;
+		fork_cycles += rdtsc() - start;
+	}
+
+	reset_process_pages(0);
+	set_pcb(NULL);
+	map_kernel_pages();
+	restore_flags(flags);
+	printf("execute+halt %u cycles, fork+exit %u cycles\n", exec_cycles / FORK_BENCH_ROUNDS, fork_cycles / FORK_BENCH_ROUNDS);
+	return result;
+}
+
+/* runs in place of scheduler_idle, which only starts after the tests, so
+ * a test whose only process sleeps has something to switch to */
+static void test_idle(){
+	while(1){
+		cli();
+		schedule();
+		pit_idle();
+	}
+}
+
+/* puts test_idle on the run queue as process pid */
+static pcb_t* test_idle_start(uint32_t pid){
+	pcb_t* idle = pcb_init((uint8_t*)"idle", 0x0, pid);
+	if(idle == NULL) return NULL;
+	idle->context_esp = scheduler_new_context(pcb_stack_top(idle), test_idle);
+	pid_claim(pid);
+	idle->state = PROCESS_RUNNABLE;
+	run_queue_add(idle);
+	return idle;
+}
+
+/* makes the test itself a runnable stand-in for process pid that owns
+ * every terminal, so the scheduler starts no shells, and starts the PIT
+ * if tick is set. Returns with interrupts on, NULL if there is no pcb */
+static pcb_t* test_standin_start(const int8_t* name, uint32_t pid, int tick){
+	uint32_t i;
+	set_pcb(NULL);
+	pcb_t* standin = pcb_init((uint8_t*)name, 0x0, pid);
+	if(standin == NULL) return NULL;
+	for(i = 0; i < MAX_TERMINALS; i++) terminal_process_nums[i] = pid;
+
+	cli();
+	pid_claim(pid);
+	standin->state = PROCESS_RUNNABLE;
+	run_queue_add(standin);
+	set_pcb(standin);
+	if(tick) pit_init();
+	sti();
+	return standin;
+}
+
+/* takes a process made by test_idle_start or for a test off the run
+ * queue and frees it, NULL is skipped. Interrupts must be off */
+static void test_process_stop(pcb_t* pcb){
+	if(pcb == NULL) return;
+	run_queue_remove(pcb);
+	pid_release(pcb->process_id);
+	pcb_free(pcb->process_id);
+}
+
+/* undoes test_standin_start and test_idle_start: stops the PIT, goes back
+ * to the kernel's pages, frees both processes and gives the terminals back
+ * to the scheduler. idle may be NULL */
+static void test_standin_stop(pcb_t* standin, pcb_t* idle){
+	uint32_t i;
+	cli();
+	disable_irq(0);
+	set_pcb(NULL);
+	map_kernel_pages();
+	test_process_stop(idle);
+	test_process_stop(standin);
+	for(i = 0; i < MAX_TERMINALS; i++) terminal_process_nums[i] = NOT_ASSIGNED;
+	sti();
+}
+
+/* background_jobs_test
+*
+* A stand-in shell on process 0 runs BACKGROUND_JOBS copies of counter,
+* first one at a time the way execute would, waiting for each before
+* spawning the next, then all at once in the background, waiting for them
+* at the end
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Starts the PIT, must run before the scheduler starts
+* Coverage: spawn, wait, scheduler_exit
+* Files: syscall.c, scheduler.c
+*/
+int background_jobs_test(){
+	TEST_HEADER;
+	int32_t pids[BACKGROUND_JOBS];
+	uint32_t i, start, serial, parallel;
+	int result = PASS;
+	pcb_t* shell = test_standin_start("shell", 0, 1);
+	if(shell == NULL) return FAIL;
+
+	start = pit_ticks;
+	for(i = 0; i < BACKGROUND_JOBS; i++){
+		pids[0] = spawn((uint8_t*)"counter");
+		if(pids[0] == FAILURE || wait(pids[0]) == FAILURE) result = FAIL;
+	}
+	serial = pit_ticks - start;
+
+	start = pit_ticks;
+	for(i = 0; i < BACKGROUND_JOBS; i++){
+		pids[i] = spawn((uint8_t*)"counter");
+		if(pids[i] == FAILURE) result = FAIL;
+	}
+	for(i = 0; i < BACKGROUND_JOBS; i++){
+		if(pids[i] != FAILURE && wait(pids[i]) == FAILURE) result = FAIL;
+	}
+	parallel = pit_ticks - start;
+
+	test_standin_stop(shell, NULL);
+
+	printf("%u jobs: %u ticks one at a time, %u ticks in the background\n", BACKGROUND_JOBS, serial, parallel);
+	return result;
+}
+
+/* reader end of pipe_throughput_bench, a kernel context on process 1 */
+static int32_t pipe_bench_fd;
+static uint32_t pipe_bench_received;
+
+/* drains the pipe until every write end is closed, then exits */
+static void pipe_bench_reader(){
+	static uint8_t buf[PIPE_BENCH_LARGE];
+	int32_t bytes;
+	pcb_t* self = find_pcb();
+	sti();
+	while((bytes = read(pipe_bench_fd, buf, PIPE_BENCH_LARGE)) > 0) pipe_bench_received += bytes;
+	close(pipe_bench_fd);
+	cli();
+	run_queue_remove(self);
+	scheduler_exit(self);
+}
+
+/* pushes PIPE_BENCH_BYTES through a pipe in chunk sized writes, returns
+ * cycles per KB or 0 if the bytes didn't all arrive */
+static uint32_t pipe_bench_run(pcb_t* writer, uint32_t chunk){
+	static uint8_t buf[PIPE_BENCH_LARGE];
+	uint32_t sent, start;
+	int32_t pid = next_available_process();
+	pcb_t* chain = writer->child_pcb;
+	pcb_t* reader = pcb_init((uint8_t*)"reader", 0x0, pid);
+	writer->child_pcb = chain;
+	if(reader == NULL) return 0;
+	reader->parent_pcb = NULL;
+	reader->detached = 1;
+	reader->owner = writer;
+
+	// the reader gets its own copy of the read end, the writer keeps only the write end
+	if(pipe_create(&writer->file_array[MIN_NUM_OF_FILES], &writer->file_array[MIN_NUM_OF_FILES + 1]) == FAILURE) return 0;
+	pipe_bench_fd = MIN_NUM_OF_FILES;
+	pipe_bench_received = 0;
+	reader->file_array[MIN_NUM_OF_FILES] = writer->file_array[MIN_NUM_OF_FILES];
+	pipe_dup(&reader->file_array[MIN_NUM_OF_FILES]);
+	close(MIN_NUM_OF_FILES);
+
+	cli();
+	reader->context_esp = scheduler_new_context(pcb_stack_top(reader), pipe_bench_reader);
+	pid_claim(pid);
+	reader->state = PROCESS_RUNNABLE;
+	run_queue_add(reader);
+	sti();
+
+	memset(buf, 'p', chunk);
+	start = rdtsc();
+	for(sent = 0; sent < PIPE_BENCH_BYTES; sent += chunk){
+		if(write(MIN_NUM_OF_FILES + 1, buf, chunk) != chunk) break;
+	}
+	close(MIN_NUM_OF_FILES + 1);
+	wait(pid);
+	if(pipe_bench_received != PIPE_BENCH_BYTES) return 0;
+	return (rdtsc() - start) / (PIPE_BENCH_BYTES / KILOBYTE);
+}
+
+/* pipe_throughput_bench
+*
+* Process 0 writes PIPE_BENCH_BYTES into a pipe that a kernel context on
+* another process drains, first in PIPE_BENCH_SMALL byte writes and then in
+* PIPE_BENCH_LARGE byte writes. Each side sleeps on the pipe while the ring
+* is full or empty, so the two take turns without the PIT
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Prints cycles per KB for both write sizes
+* Coverage: pipe_create, pipe_read, pipe_write, pipe_close, wait
+* Files: pipe.c, syscall.c
+*/
+int pipe_throughput_bench(){
+	TEST_HEADER;
+	uint32_t small, large;
+	set_pcb(NULL);
+	pcb_t* writer = pcb_init((uint8_t*)"writer", 0x0, 0);
+	if(writer == NULL) return FAIL;
+
+	cli();
+	pid_claim(0);
+	writer->state = PROCESS_RUNNABLE;
+	run_queue_add(writer);
+	set_pcb(writer);
+	sti();
+
+	small = pipe_bench_run(writer, PIPE_BENCH_SMALL);
+	large = pipe_bench_run(writer, PIPE_BENCH_LARGE);
+
+	cli();
+	run_queue_remove(writer);
+	pid_release(0);
+	set_pcb(NULL);
+	map_kernel_pages();
+	sti();
+
+	printf("pipe: %u cycles/KB in %u byte writes, %u cycles/KB in %u byte writes\n", small, PIPE_BENCH_SMALL, large, PIPE_BENCH_LARGE);
+	return (small != 0 && large != 0) ? PASS : FAIL;
+}
+
+/* signal_delivery_test
+*
+* A stand-in process 0 with a mapped user stack sits in a system call.
+* USER1 with a handler set has to turn the syscall exit into a jump to the
+* handler with the signal number and linkage on the user stack, and
+* sigreturn has to put every register back, the return value included.
+* ALARM without a handler has to be dropped. Then times SIGNAL_TEST_ROUNDS
+* raise, deliver and sigreturn round trips
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Prints cycles per round trip
+* Coverage: set_handler, signal_syscall_exit, sigreturn
+* Files: signal.c, syscall.c
+*/
+int signal_delivery_test(){
+	TEST_HEADER;
+	uint32_t i, start, flags, handler = PROG_CODE_START;
+	int result = PASS;
+	syscall_frame_t saved;
+	set_pcb(NULL);
+	pcb_t* pcb = pcb_init((uint8_t*)"signal", 0x0, 0);
+	if(pcb == NULL) return FAIL;
+	cli_and_save(flags);
+	reset_process_pages(0);
+	get_program_table(0)[NUM_OF_ENTRIES - 1] = frame_alloc(0) | FLAG_P | FLAG_RW | FLAG_US;
+	map_process_pages(0);
+	set_pcb(pcb);
+
+	syscall_frame_t* frame = get_syscall_frame(pcb);
+	memset(frame, 0, sizeof(syscall_frame_t));
+	frame->ebx = 1;
+	frame->edi = 5;
+	frame->eip = PROG_CODE_START + FOUR_KB;
+	frame->cs = USER_CS;
+	frame->eflags = EFLAGS_IF;
+	frame->esp = PROG_STACK_TOP;
+	frame->ss = USER_DS;
+	saved = *frame;
+
+	if(set_handler(SIGNAL_USER1, (void*)handler) != SUCCESS || set_handler(NUM_SIGNALS, (void*)handler) != FAILURE) result = FAIL;
+	signal_raise(pcb, SIGNAL_USER1);
+	if(signal_syscall_exit(frame, SIGNAL_TEST_RET) != SIGNAL_TEST_RET) result = FAIL;
+	if(frame->eip != handler || ((uint32_t*)frame->esp)[1] != SIGNAL_USER1) result = FAIL;
+	if(*(uint8_t*)((uint32_t*)frame->esp)[0] != 0xB8 || pcb->signals_masked != SIGNAL_ALL) result = FAIL;
+
+	// the handler returns into the linkage, which makes the sigreturn call
+	frame->esp += LONG;
+	if(sigreturn() != SIGNAL_TEST_RET) result = FAIL;
+	if(frame->ebx != saved.ebx || frame->edi != saved.edi || frame->eip != saved.eip) result = FAIL;
+	if(frame->esp != saved.esp || frame->eflags != saved.eflags || pcb->signals_masked != 0) result = FAIL;
+
+	signal_raise(pcb, SIGNAL_ALARM);
+	signal_syscall_exit(frame, SIGNAL_TEST_RET);
+	if(frame->eip != saved.eip || pcb->signals_pending != 0) result = FAIL;
+
+	start = rdtsc();
+	for(i = 0; i < SIGNAL_TEST_ROUNDS; i++){
+		signal_raise(pcb, SIGNAL_USER1);
+		signal_syscall_exit(frame, SIGNAL_TEST_RET);
+		frame->esp += LONG;
+		sigreturn();
+	}
+	start = (rdtsc() - start) / SIGNAL_TEST_ROUNDS;
+
+	reset_process_pages(0);
+	set_pcb(NULL);
+	map_kernel_pages();
+	restore_flags(flags);
+	printf("signal raise, delivery and sigreturn: %u cycles\n", start);
+	return result;
+}
+
+/* signal_fault_test
+*
+* A stand-in process 0 with a mapped user stack sits in a system call.
+* A SEGFAULT without a handler can't be raised. With a handler it is raised
+* and delivered, and while that handler runs a second SEGFAULT, the handler
+* itself faulting, can't be raised either, the process has to be halted
+* rather than fault on the same instruction forever. After sigreturn it can
+* be raised again
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: None
+* Coverage: signal_exception, signal_syscall_exit, sigreturn
+* Files: signal.c, exception.c
+*/
+int signal_fault_test(){
+	TEST_HEADER;
+	uint32_t flags, handler = PROG_CODE_START;
+	int result = PASS;
+	set_pcb(NULL);
+	pcb_t* pcb = pcb_init((uint8_t*)"signal", 0x0, 0);
+	if(pcb == NULL) return FAIL;
+	cli_and_save(flags);
+	reset_process_pages(0);
+	get_program_table(0)[NUM_OF_ENTRIES - 1] = frame_alloc(0) | FLAG_P | FLAG_RW | FLAG_US;
+	map_process_pages(0);
+	set_pcb(pcb);
+
+	syscall_frame_t* frame = get_syscall_frame(pcb);
+	memset(frame, 0, sizeof(syscall_frame_t));
+	frame->eip = PROG_CODE_START + FOUR_KB;
+	frame->cs = USER_CS;
+	frame->eflags = EFLAGS_IF;
+	frame->esp = PROG_STACK_TOP;
+	frame->ss = USER_DS;
+
+	if(signal_exception(pcb, SIGNAL_SEGFAULT) != FAILURE || pcb->signals_pending != 0) result = FAIL;
+	set_handler(SIGNAL_SEGFAULT, (void*)handler);
+	if(signal_exception(pcb, SIGNAL_SEGFAULT) != SUCCESS) result = FAIL;
+	signal_syscall_exit(frame, SIGNAL_TEST_RET);
+	if(frame->eip != handler || pcb->signals_pending != 0) result = FAIL;
+
+	// the handler faults
+	if(signal_exception(pcb, SIGNAL_SEGFAULT) != FAILURE || pcb->signals_pending != 0) result = FAIL;
+
+	frame->esp += LONG;
+	sigreturn();
+	if(signal_exception(pcb, SIGNAL_SEGFAULT) != SUCCESS) result = FAIL;
+	pcb->signals_pending = 0;
+
+	reset_process_pages(0);
+	set_pcb(NULL);
+	map_kernel_pages();
+	restore_flags(flags);
+	return result;
+}
+
+/* signal_wake_test
+*
+* Two processes sleep on one wait queue. USER1 without a handler would be
+* dropped, so it has to leave the first asleep. INTERRUPT would kill it, so
+* it has to take the first off the queue and make it runnable while the
+* second keeps sleeping. The second is then woken the usual way
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Borrows pcbs 4 and 5, must run before the scheduler starts
+* Coverage: signal_raise, signal_interrupts, wait_queue_wake
+* Files: signal.c, wait_queue.c
+*/
+int signal_wake_test(){
+	TEST_HEADER;
+	int result = PASS;
+	wait_queue_t queue;
+	wait_queue_init(&queue);
+	set_pcb(NULL);
+	pcb_t* a = pcb_init((uint8_t*)"a", 0x0, 4);
+	pcb_t* b = pcb_init((uint8_t*)"b", 0x0, 5);
+	if(a == NULL || b == NULL) return FAIL;
+
+	cli();
+	a->state = b->state = PROCESS_BLOCKED;
+	a->wait_queue = b->wait_queue = &queue;
+	queue.first = a;
+	a->wait_next = queue.last = b;
+
+	signal_raise(a, SIGNAL_USER1);
+	if(a->state != PROCESS_BLOCKED || queue.first != a) result = FAIL;
+	signal_raise(a, SIGNAL_INTERRUPT);
+	if(a->state != PROCESS_RUNNABLE || a->wait_queue != NULL || a->run_next == NULL) result = FAIL;
+	if(queue.first != b || queue.last != b || b->state != PROCESS_BLOCKED) result = FAIL;
+	wait_queue_wake_all(&queue);
+	if(b->state != PROCESS_RUNNABLE || b->wait_queue != NULL || queue.first != NULL) result = FAIL;
+
+	run_queue_remove(a);
+	run_queue_remove(b);
+	a->signals_pending = 0;
+	sti();
+	return result;
+}
+
+/* timers that never fire, kept pending during timer_accuracy_bench */
+static void timer_bench_idle(void* data){
+}
+
+/* timer_accuracy_bench
+*
+* A stand-in process 0 sleeps TIMER_BENCH_ROUNDS times for TIMER_BENCH_MS
+* with TIMER_BENCH_PENDING other timers on the wheel, and counts the PIT
+* ticks each sleep took. No sleep may end early and the spread between the
+* shortest and longest has to stay within a tick. Then the PIT is stopped
+* and one turn of the wheel is ticked by hand to time a tick with every
+* timer pending
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Starts the PIT, borrows process 1 to idle, must run before
+*               the scheduler starts
+* Coverage: sleep, timer_add, timer_tick, timer_del
+* Files: timer.c, syscall.c, pit.c
+*/
+int timer_accuracy_bench(){
+	TEST_HEADER;
+	static ktimer_t pending[TIMER_BENCH_PENDING];
+	uint32_t i, start, ticks, shortest = 0xFFFFFFFF, longest = 0, total = 0;
+	int result = PASS;
+	pcb_t* sleeper = test_standin_start("sleeper", 0, 1);
+	if(sleeper == NULL) return FAIL;
+
+	cli();
+	pcb_t* idle = test_idle_start(1);
+	if(idle == NULL){
+		test_standin_stop(sleeper, NULL);
+		return FAIL;
+	}
+	for(i = 0; i < TIMER_BENCH_PENDING; i++){
+		timer_setup(&pending[i], timer_bench_idle, NULL);
+		timer_add(&pending[i], 4 * TIMER_WHEEL_SLOTS + i);
+	}
+	sti();
+
+	for(i = 0; i < TIMER_BENCH_ROUNDS; i++){
+		start = pit_ticks;
+		if(sleep(TIMER_BENCH_MS) != SUCCESS) result = FAIL;
+		ticks = pit_ticks - start;
+		total += ticks;
+		if(ticks < shortest) shortest = ticks;
+		if(ticks > longest) longest = ticks;
+	}
+	if(shortest * MS_PER_SECOND < TIMER_BENCH_MS * pit_hz || longest - shortest > 1) result = FAIL;
+
+	cli();
+	disable_irq(0);
+	start = rdtsc();
+	for(i = 1; i <= TIMER_WHEEL_SLOTS; i++) timer_tick(pit_ticks + i);
+	start = (rdtsc() - start) / TIMER_WHEEL_SLOTS;
+	for(i = 0; i < TIMER_BENCH_PENDING; i++){
+		if(!pending[i].pending) result = FAIL;
+		timer_del(&pending[i]);
+	}
+	test_standin_stop(sleeper, idle);
+
+	printf("sleep(%u): %u to %u ticks, %u on average, at %u Hz\n", TIMER_BENCH_MS, shortest, longest, total / TIMER_BENCH_ROUNDS, pit_hz);
+	printf("tick with %u timers pending: %u cycles\n", TIMER_BENCH_PENDING, start);
+	return result;
+}
+
+/* rtc_virtual_test
+*
+* A stand-in process 0 opens the RTC twice, sets one descriptor to
+* RTC_TEST_FAST Hz and the other to RTC_TEST_SLOW Hz, and reads the slow
+* one RTC_TEST_READS times. The reads have to take RTC_TEST_READS slow
+* periods of hardware interrupts, and the fast clock has to have counted its own
+* ticks meanwhile without anyone reading it
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Borrows process 1 to idle, must run before the scheduler
+*               starts
+* Coverage: rtc_read, rtc_write, rtc_set_virtual_rate, rtc_close
+* Files: rtc.c
+*/
+int rtc_virtual_test(){
+	TEST_HEADER;
+	int32_t fast_fd, slow_fd, freq, i;
+	uint32_t start, interrupts, fast_ticks;
+	int result = PASS;
+	pcb_t* reader = test_standin_start("reader", 0, 0);
+	if(reader == NULL) return FAIL;
+
+	cli();
+	pcb_t* idle = test_idle_start(1);
+	sti();
+	if(idle == NULL){
+		test_standin_stop(reader, NULL);
+		return FAIL;
+	}
+
+	fast_fd = open((uint8_t*)"rtc");
+	slow_fd = open((uint8_t*)"rtc");
+	freq = RTC_TEST_FAST;
+	if(fast_fd == FAILURE || slow_fd == FAILURE || write(fast_fd, &freq, sizeof(freq)) != 0) result = FAIL;
+	freq = RTC_TEST_SLOW;
+	if(write(slow_fd, &freq, sizeof(freq)) != 0) result = FAIL;
+	freq = RTC_TEST_SLOW + 1;
+	if(write(slow_fd, &freq, sizeof(freq)) != FAILURE) result = FAIL;
+
+	if(result == PASS){
+		start = rtc_interrupts;
+		for(i = 0; i < RTC_TEST_READS; i++) read(slow_fd, NULL, 0);
+		interrupts = rtc_interrupts - start;
+		fast_ticks = ((rtc_clock_t*)reader->file_array[fast_fd].object)->pending;
+		// the first period may have started just before start was read
+		if(interrupts > RTC_TEST_READS * (RTC_BASE_FREQ / RTC_TEST_SLOW)) result = FAIL;
+		if(interrupts < (RTC_TEST_READS - 1) * (RTC_BASE_FREQ / RTC_TEST_SLOW)) result = FAIL;
+		if(fast_ticks < interrupts / (RTC_BASE_FREQ / RTC_TEST_FAST)) result = FAIL;
+		printf("%u reads at %u Hz took %u RTC interrupts, the %u Hz clock counted %u ticks\n",
+			RTC_TEST_READS, RTC_TEST_SLOW, interrupts, RTC_TEST_FAST, fast_ticks);
+	}
+	close(fast_fd);
+	close(slow_fd);
+
+	test_standin_stop(reader, idle);
+	return result;
+}
+
+/* quantum_bench
+*
+* A stand-in process 0 does QUANTUM_BENCH_CYCLES of busy work at each PIT
+* rate from PIT_MIN_HZ to PIT_MAX_HZ, counting the interrupts and how much
+* work got done, which shows what every preemption costs. Then it sleeps
+* QUANTUM_BENCH_IDLE_MS at PIT_MAX_HZ with the periodic tick and again
+* tickless, and the tickless sleep has to take fewer interrupts
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Starts the PIT, borrows process 1 to idle, must run before
+*               the scheduler starts
+* Coverage: set_quantum, pit_set_hz, pit_idle, timer_next
+* Files: pit.c, timer.c, syscall.c
+*/
+int quantum_bench(){
+	TEST_HEADER;
+	static const uint32_t rates[] = {PIT_MIN_HZ, PIT_DEFAULT_HZ, 100, 250, PIT_MAX_HZ};
+	volatile uint32_t work;
+	uint32_t i, start, interrupts, periodic = 0, tickless = 0;
+	int result = PASS;
+	pcb_t* worker = test_standin_start("worker", 0, 1);
+	if(worker == NULL) return FAIL;
+
+	/* throughput, nothing else runs so every tick preempts into the same process */
+	for(i = 0; i < sizeof(rates) / sizeof(rates[0]); i++){
+		if(set_quantum(MS_PER_SECOND / rates[i]) != SUCCESS) result = FAIL;
+		work = 0;
+		interrupts = pit_interrupts;
+		start = rdtsc();
+		while(rdtsc() - start < QUANTUM_BENCH_CYCLES) work++;
+		interrupts = pit_interrupts - interrupts;
+		printf("%u Hz: %u interrupts, %u units of work\n", pit_hz, interrupts, work);
+	}
+	if(set_quantum(0) != FAILURE || pit_set_hz(PIT_MAX_HZ + 1) != FAILURE) result = FAIL;
+
+	/* idle, the only other process is the idle loop */
+	cli();
+	pcb_t* idle = test_idle_start(1);
+	sti();
+	if(idle == NULL){
+		test_standin_stop(worker, NULL);
+		return FAIL;
+	}
+	pit_set_hz(PIT_MAX_HZ);
+	pit_tickless = 0;
+	interrupts = pit_interrupts;
+	sleep(QUANTUM_BENCH_IDLE_MS);
+	periodic = pit_interrupts - interrupts;
+	pit_tickless = 1;
+	interrupts = pit_interrupts;
+	sleep(QUANTUM_BENCH_IDLE_MS);
+	tickless = pit_interrupts - interrupts;
+	if(tickless >= periodic) result = FAIL;
+	printf("sleep(%u) at %u Hz: %u interrupts periodic, %u tickless\n", QUANTUM_BENCH_IDLE_MS, pit_hz, periodic, tickless);
+
+	pit_set_hz(kernel_config.pit_hz);
+	pit_tickless = kernel_config.tickless;
+	test_standin_stop(worker, idle);
+	return result;
+}
+
+/* profile_test
+*
+* A stand-in process 0 copies PROFILE_TEST_BYTES back and forth with
+* memmove for PROFILE_TEST_CYCLES with the PIT at PIT_MAX_HZ and the
+* profiler on. Every sample has to be in the histogram or counted as
+* dropped, and most of them have to land inside memmove in process 0
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Starts the PIT, must run before the scheduler starts
+* Coverage: profile_start, profile_tick, profile_copy, profile_stop
+* Files: profile.c, pit.c
+*/
+int profile_test(){
+	TEST_HEADER;
+	static uint8_t from[PROFILE_TEST_BYTES], to[PROFILE_TEST_BYTES];
+	static profile_sample_t samples[PROFILE_SLOTS];
+	uint32_t i, start, used, counted = 0, in_memmove = 0;
+	int result = PASS;
+	pcb_t* worker = test_standin_start("worker", 0, 1);
+	if(worker == NULL) return FAIL;
+	pit_set_hz(PIT_MAX_HZ);
+
+	if(profile_start() != SUCCESS) result = FAIL;
+	start = rdtsc();
+	while(rdtsc() - start < PROFILE_TEST_CYCLES){
+		memmove(to, from, PROFILE_TEST_BYTES);
+		memmove(from, to, PROFILE_TEST_BYTES);
+	}
+	profile_stop();
+
+	used = profile_copy(samples, PROFILE_SLOTS);
+	for(i = 0; i < used; i++){
+		counted += samples[i].count;
+		// lib.c puts strncmp right after memmove
+		if(samples[i].pid == 0 && samples[i].cpl == 0 && samples[i].eip >= (uint32_t)memmove &&
+			samples[i].eip < (uint32_t)strncmp) in_memmove += samples[i].count;
+	}
+	if(counted + profile_dropped != profile_samples || profile_samples == 0) result = FAIL;
+	if(in_memmove * 2 < profile_samples) result = FAIL;
+	printf("%u samples in %u buckets, %u dropped, %u in memmove\n", profile_samples, used, profile_dropped, in_memmove);
+
+	pit_set_hz(kernel_config.pit_hz);
+	test_standin_stop(worker, NULL);
+	return result;
+}
+
+#define TOTAL_VIDEO_SPACE    3840    // bytes of every screen row but the last
+#define VIDEO_SPACE_PER_ROW  160     // bytes of a screen row
+
+/* putc as it was before the shadow screen: two byte writes straight to
+ * video memory, a memmove of the screen per scroll and a cursor move per
+ * character. Only for console_write_bench, writes to terminal 0 */
+static void legacy_putc(uint8_t c){
+	int32_t j;
+	if(c != '\n'){
+		*(uint8_t *)(video_mem + ((NUM_COLS * sscreeny[0] + sscreenx[0]) << 1)) = c;
+		*(uint8_t *)(video_mem + ((NUM_COLS * sscreeny[0] + sscreenx[0]) << 1) + 1) = ATTRIB;
+		sscreenx[0]++;
+	}
+	if(c == '\n' || sscreenx[0] == NUM_COLS){
+		sscreenx[0] = 0;
+		if(sscreeny[0] < NUM_ROWS - 1) sscreeny[0]++;
+		else {
+			memmove(video_mem, video_mem + VIDEO_SPACE_PER_ROW, TOTAL_VIDEO_SPACE);
+			for(j = 0; j < NUM_COLS; j++){
+				*(uint8_t *)(video_mem + ((NUM_COLS * (NUM_ROWS - 1) + j) << 1)) = ' ';
+				*(uint8_t *)(video_mem + ((NUM_COLS * (NUM_ROWS - 1) + j) << 1) + 1) = ATTRIB;
+			}
+		}
+	}
+	flashy_set(sscreenx[0] + sscreeny[0] * NUM_COLS);
+}
+
+/* console_write_bench
+*
+* A stand-in process 0 on terminal 0 prints CONSOLE_BENCH_LINE byte lines
+* for CONSOLE_BENCH_TICKS PIT ticks each way and counts the characters.
+* Before: legacy_putc per byte. After: terminal_write through the shadow
+* screen, flushed once per call
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Starts the PIT, clears the screen, must run before the
+*               scheduler starts
+* Coverage: terminal_write, putc, console_put, console_scroll, console_flush
+* Files: console.c, lib.c, terminal.c
+*/
+int console_write_bench(){
+	TEST_HEADER;
+	static uint8_t line[CONSOLE_BENCH_LINE];
+	uint32_t i, start, ticks, before = 0, after = 0;
+	int result = PASS;
+	for(i = 0; i < CONSOLE_BENCH_LINE - 1; i++) line[i] = 'a' + i % 26;
+	line[CONSOLE_BENCH_LINE - 1] = '\n';
+	pcb_t* writer = test_standin_start("writer", 0, 1);
+	if(writer == NULL) return FAIL;
+
+	/* before: every byte goes to video memory and moves the cursor */
+	start = pit_ticks;
+	while((ticks = pit_ticks - start) < CONSOLE_BENCH_TICKS){
+		for(i = 0; i < CONSOLE_BENCH_LINE; i++) legacy_putc(line[i]);
+		before += CONSOLE_BENCH_LINE;
+	}
+	before = before / ticks * pit_hz;
+
+	/* after: bytes go to the shadow screen, dirty rows are copied once a write */
+	start = pit_ticks;
+	while((ticks = pit_ticks - start) < CONSOLE_BENCH_TICKS){
+		if(terminal_write(1, line, CONSOLE_BENCH_LINE) != CONSOLE_BENCH_LINE) result = FAIL;
+		after += CONSOLE_BENCH_LINE;
+	}
+	after = after / ticks * pit_hz;
+
+	test_standin_stop(writer, NULL);
+
+	clear_all();
+	if(after <= before) result = FAIL;
+	printf("terminal_write: %u chars/s before, %u chars/s after\n", before, after);
+	return result;
+}
+
+/* console_scroll_bench
+*
+* Prints CONSOLE_SCROLL_LINES short lines on terminal 0, each of which
+* scrolls the screen once the cursor reaches the bottom, and times a line.
+* Before: legacy_putc, a memmove of the screen per scroll. After:
+* terminal_write, which moves the CRTC window down a row and writes the
+* new row, copying the whole screen only when the window wraps
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Clears the screen
+* Coverage: console_scroll, console_flush, terminal_write
+* Files: console.c, lib.c, terminal.c
+*/
+int console_scroll_bench(){
+	TEST_HEADER;
+	static const uint8_t line[] = "scroll\n";
+	uint32_t i, start, before, after;
+	int result = PASS;
+
+	/* before: memmove the screen for every line */
+	console_home(cur_terminal);
+	start = rdtsc();
+	for(i = 0; i < CONSOLE_SCROLL_LINES; i++){
+		legacy_putc('s');
+		legacy_putc('\n');
+	}
+	before = (rdtsc() - start) / CONSOLE_SCROLL_LINES;
+
+	/* after: move the window and write one row */
+	clear_all();
+	start = rdtsc();
+	for(i = 0; i < CONSOLE_SCROLL_LINES; i++){
+		if(terminal_write(1, line, sizeof(line) - 1) != sizeof(line) - 1) result = FAIL;
+	}
+	after = (rdtsc() - start) / CONSOLE_SCROLL_LINES;
+
+	clear_all();
+	if(after >= before) result = FAIL;
+	printf("scrolling line: %u cycles before, %u cycles after\n", before, after);
+	return result;
+}
+
+/* console_bulk_bench
+*
+* Prints CONSOLE_BULK_BYTES of 79 character lines on terminal 0 three ways
+* and times a character. Before: legacy_putc, straight to video memory with
+* a cursor move each. Then putc into the shadow screen with one flush at
+* the end. After: terminal_write, a run of characters at a time
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Clears the screen
+* Coverage: console_write, console_flush, terminal_write
+* Files: console.c, terminal.c
+*/
+int console_bulk_bench(){
+	TEST_HEADER;
+	static uint8_t text[CONSOLE_BULK_BYTES];
+	uint32_t i, start, legacy, shadow, spans;
+	int result = PASS;
+	for(i = 0; i < CONSOLE_BULK_BYTES; i++) text[i] = (i % NUM_COLS == NUM_COLS - 1) ? '\n' : 'a' + i % 26;
+
+	/* before: one byte at a time into video memory */
+	console_home(cur_terminal);
+	start = rdtsc();
+	for(i = 0; i < CONSOLE_BULK_BYTES; i++) legacy_putc(text[i]);
+	legacy = (rdtsc() - start) / CONSOLE_BULK_BYTES;
+
+	/* one byte at a time into the shadow screen */
+	clear_all();
+	start = rdtsc();
+	for(i = 0; i < CONSOLE_BULK_BYTES; i++) putc(text[i]);
+	console_flush(cur_scheduled_terminal);
+	shadow = (rdtsc() - start) / CONSOLE_BULK_BYTES;
+
+	/* after: runs of characters */
+	clear_all();
+	start = rdtsc();
+	if(terminal_write(1, text, CONSOLE_BULK_BYTES) != CONSOLE_BULK_BYTES) result = FAIL;
+	spans = (rdtsc() - start) / CONSOLE_BULK_BYTES;
+
+	clear_all();
+	if(spans >= shadow) result = FAIL;
+	printf("bulk print: %u cycles/char direct, %u with putc, %u with runs\n", legacy, shadow, spans);
+	return result;
+}
+
+#define LEGACY_BACKUP_BASE   0xBC000 // where each terminal's screen was saved, a page each
+
+/* swap_terminal as it was before every terminal had its own video memory:
+ * bring both terminals up to date, save the shown screen to the old
+ * terminal's backup page and copy the new one's in, then repoint the
+ * vidmap pages of both terminals' programs. The backup pages overlap
+ * terminal 2's video memory now, console_switch_bench redraws it after */
+static void legacy_swap_terminal(uint8_t new_terminal){
+	pcb_t* pcb;
+	uint32_t* vidmem_entry;
+	console_flush(cur_terminal);
+	console_flush(new_terminal);
+	memcpy((uint8_t*)(LEGACY_BACKUP_BASE + cur_terminal * FOUR_KB), (uint8_t*)VIDEO, CONSOLE_CELLS * sizeof(uint16_t));
+	memcpy((uint8_t*)VIDEO, (uint8_t*)(LEGACY_BACKUP_BASE + new_terminal * FOUR_KB), CONSOLE_CELLS * sizeof(uint16_t));
+
+	pcb = get_pcb(terminal_process_nums[cur_terminal]);
+	pcb = (pcb != NULL) ? pcb->child_pcb : NULL;
+	while(pcb != NULL){
+		vidmem_entry = get_vidmem_entry(pcb->process_id);
+		*vidmem_entry = (*vidmem_entry & 0xFF) | (LEGACY_BACKUP_BASE + cur_terminal * FOUR_KB);
+		pcb = pcb->child_pcb;
+	}
+	pcb = get_pcb(terminal_process_nums[new_terminal]);
+	pcb = (pcb != NULL) ? pcb->child_pcb : NULL;
+	while(pcb != NULL){
+		vidmem_entry = get_vidmem_entry(pcb->process_id);
+		*vidmem_entry = (*vidmem_entry & 0xFF) | VIDEO;
+		pcb = pcb->child_pcb;
+	}
+	flashy_set(NUM_COLS * sscreeny[new_terminal] + sscreenx[new_terminal]);
+
+	if (new_terminal == 0) {cur_keyboard = keyboard_buf_0; text_colour(BLACK, WHITE);}
+	else if (new_terminal == 1) {cur_keyboard = keyboard_buf_1; text_colour(LIGHT_RED,DARK_GRAY);}
+	else {cur_keyboard = keyboard_buf_2; text_colour(LIGHT_GREEN,LIGHT_BLUE);}
+	cur_terminal = new_terminal;
+	CURSOR = (cur_scheduled_terminal == cur_terminal);
+}
+
+/* a busy program, prints lines on its terminal forever */
+static void switch_bench_writer(){
+	static const uint8_t line[] = "busy busy busy busy busy busy busy busy\n";
+	sti();
+	while(1) terminal_write(1, line, sizeof(line) - 1);
+}
+
+/* switches to the next terminal CONSOLE_SWITCHES times, like Alt+F with
+ * interrupts off, CONSOLE_SWITCH_TICKS PIT ticks apart, and returns the
+ * average cycles a switch took. Ends on terminal 0 with every terminal
+ * redrawn, the legacy switch leaves video memory in a mess */
+static uint32_t switch_bench_run(int legacy){
+	uint32_t i, start, flags, cycles = 0;
+	uint8_t next;
+	for(i = 0; i < CONSOLE_SWITCHES; i++){
+		start = pit_ticks;
+		while(pit_ticks - start < CONSOLE_SWITCH_TICKS);
+
+		next = (cur_terminal + 1) % kernel_config.terminals;
+		cli_and_save(flags);
+		start = rdtsc();
+		if(legacy) legacy_swap_terminal(next);
+		else swap_terminal(next);
+		cycles += rdtsc() - start;
+		restore_flags(flags);
+	}
+
+	cli_and_save(flags);
+	if(legacy) legacy_swap_terminal(0);
+	else swap_terminal(0);
+	for(i = 0; i < MAX_TERMINALS; i++){
+		consoles[i].dirty = CONSOLE_ALL_ROWS;
+		console_flush(i);
+	}
+	console_switch(cur_terminal);
+	restore_flags(flags);
+	return cycles / CONSOLE_SWITCHES;
+}
+
+/* console_switch_bench
+*
+* Times a terminal switch with switch_bench_run, the old way with
+* legacy_swap_terminal and the new way with swap_terminal, in three
+* settings: every terminal blank, every terminal full of text, and a busy
+* program printing without stopping in every terminal. Each terminal's
+* shell is a stand-in with the busy program as its child, so the old way
+* has chains to walk. The new way has to be faster in all three and take
+* about as long on full screens as on blank ones
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Starts the PIT, clears every terminal, must run before the
+*               scheduler starts
+* Coverage: swap_terminal, console_switch, console_flush
+* Files: multi_term.c, console.c
+*/
+int console_switch_bench(){
+	TEST_HEADER;
+	static uint8_t text[CONSOLE_CELLS];
+	pcb_t* shells[MAX_TERMINALS];
+	pcb_t* writers[MAX_TERMINALS];
+	uint32_t i, blank_before, blank_after, full_before, full_after, busy_before, busy_after;
+	pcb_t* switcher;
+	int result = PASS;
+	if(kernel_config.terminals < 2) return FAIL;
+	for(i = 0; i < CONSOLE_CELLS; i++) text[i] = 'a' + i % 26;
+	switcher = test_standin_start("switcher", 0, 1);
+	if(switcher == NULL) return FAIL;
+
+	/* terminal i: shell on process 4 + i running a writer on process 1 + i */
+	cli();
+	for(i = 0; i < MAX_TERMINALS; i++){
+		shells[i] = pcb_init((uint8_t*)"shell", 0x0, i + 1 + MAX_TERMINALS);
+		writers[i] = pcb_init((uint8_t*)"writer", 0x0, i + 1);
+		if(shells[i] == NULL || writers[i] == NULL) break;
+		pid_claim(i + 1 + MAX_TERMINALS);
+		pid_claim(i + 1);
+		shells[i]->child_pcb = writers[i];
+		writers[i]->child_pcb = NULL;
+		writers[i]->terminal = i;
+		writers[i]->context_esp = scheduler_new_context(pcb_stack_top(writers[i]), switch_bench_writer);
+		writers[i]->state = PROCESS_RUNNABLE;
+		terminal_process_nums[i] = i + 1 + MAX_TERMINALS;
+	}
+	set_pcb(switcher);
+	sti();
+	if(i < MAX_TERMINALS) result = FAIL;
+
+	if(result == PASS){
+		/* blank screens */
+		for(i = 0; i < MAX_TERMINALS; i++) console_clear(i, terminal_colors[i]);
+		blank_before = switch_bench_run(1);
+		blank_after = switch_bench_run(0);
+
+		/* screens full of text, nothing printing */
+		for(i = 0; i < MAX_TERMINALS; i++){
+			console_write(i, text, CONSOLE_CELLS - 1, terminal_colors[i]);
+			console_flush(i);
+		}
+		full_before = switch_bench_run(1);
+		full_after = switch_bench_run(0);
+
+		/* a busy program in every terminal */
+		cli();
+		for(i = 0; i < MAX_TERMINALS; i++) run_queue_add(writers[i]);
+		sti();
+		busy_before = switch_bench_run(1);
+		busy_after = switch_bench_run(0);
+
+		if(blank_after >= blank_before || full_after >= full_before || busy_after >= busy_before) result = FAIL;
+		if(full_after > 2 * blank_after) result = FAIL;
+		printf("terminal switch, cycles before/after: blank %u/%u, full %u/%u, busy %u/%u\n",
+			blank_before, blank_after, full_before, full_after, busy_before, busy_after);
+	}
+
+	cli();
+	for(i = 0; i < MAX_TERMINALS; i++){
+		if(writers[i] != NULL) *get_vidmem_entry(writers[i]->process_id) = 0x00000000;
+		test_process_stop(writers[i]);
+		test_process_stop(shells[i]);
+	}
+	test_standin_stop(switcher, NULL);
+	for(i = 0; i < MAX_TERMINALS; i++){
+		sscreenx[i] = 0;
+		sscreeny[i] = 0;
+		console_clear(i, terminal_colors[i]);
+		console_flush(i);
+	}
+	clear_all();
+	return result;
+}
+
+/* whether screen row y of the shown terminal starts with "line n" */
+static int scrollback_row_is(uint32_t y, uint32_t n){
+	int8_t expect[CONSOLE_HISTORY_LINE];
+	uint16_t* screen = (uint16_t*)CONSOLE_REGION(cur_terminal) + consoles[cur_terminal].window;
+	uint32_t i;
+	strcpy(expect, "line ");
+	itoa(n, expect + strlen(expect), 10);
+	for(i = 0; expect[i] != '\0'; i++){
+		if((screen[y * NUM_COLS + i] & CONSOLE_CHAR_MASK) != (uint8_t)expect[i]) return 0;
+	}
+	return 1;
+}
+
+/* console_scrollback_test
+*
+* Prints twice as many numbered lines as the shown terminal keeps history
+* for, timing a line while the history fills and once it is full and
+* every scroll overwrites its oldest row, which must not cost more. Then
+* scrolls back the way Shift+PgUp/PgDn do and checks the screen shows the
+* right lines, stops at the oldest one, stays put while more is printed
+* and goes back to the live screen
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Clears the screen
+* Coverage: console_scroll, console_view, console_live, console_flush
+* Files: console.c
+*/
+int console_scrollback_test(){
+	TEST_HEADER;
+	console_t* console = &consoles[cur_terminal];
+	uint32_t i, start, depth, lines, filling, full;
+	int result = PASS;
+	depth = console->rows - NUM_ROWS;
+	if(depth < NUM_ROWS) return FAIL;
+	lines = 2 * depth;
+
+	clear_all();
+	start = rdtsc();
+	for(i = 0; i < depth; i++) printf("line %u\n", i);
+	filling = (rdtsc() - start) / depth;
+	start = rdtsc();
+	for(; i < lines; i++) printf("line %u\n", i);
+	full = (rdtsc() - start) / depth;
+	if(console->history != depth) result = FAIL;
+
+	/* the live screen ends with the last line above the cursor */
+	if(!scrollback_row_is(NUM_ROWS - 2, lines - 1)) result = FAIL;
+
+	/* back past the oldest row stops at it */
+	console_view(cur_terminal, depth + NUM_ROWS);
+	if(console->view != depth || !scrollback_row_is(0, lines - (NUM_ROWS - 1) - depth)) result = FAIL;
+
+	/* a page forward */
+	console_view(cur_terminal, -CONSOLE_PAGE_ROWS);
+	if(!scrollback_row_is(0, lines - depth)) result = FAIL;
+
+	/* printing more doesn't move what is being looked at */
+	printf("line %u\n", lines);
+	if(!scrollback_row_is(0, lines - depth)) result = FAIL;
+
+	console_live(cur_terminal);
+	if(console->view != 0 || !scrollback_row_is(NUM_ROWS - 2, lines)) result = FAIL;
+
+	clear_all();
+	if(full > 2 * filling) result = FAIL;
+	printf("%u rows of history: %u cycles/line filling, %u cycles/line full\n", depth, filling, full);
+	return result;
+}
+
+/* kmalloc_bench
+*
+* Allocates SLAB_BENCH_OBJECTS small objects, fills each with its own
+* pattern and checks none of them overlap, then frees them. Before: every
+* object takes a whole frame from the buddy allocator. After: objects come
+* from the kmalloc size class slabs
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Prints cycles per alloc and free
+* Coverage: kmalloc, kfree, frame_alloc
+* Files: slab.c, frame_alloc.c
+*/
+int kmalloc_bench(){
+	TEST_HEADER;
+	static uint8_t* objects[SLAB_BENCH_OBJECTS];
+	uint32_t i, j, start, frame_cycles, alloc_cycles, free_cycles;
+	int result = PASS;
+
+	/* before: one frame per object */
+	start = rdtsc();
+	for(i = 0; i < SLAB_BENCH_OBJECTS; i++) objects[i] = (uint8_t*)frame_alloc(0);
+	for(i = 0; i < SLAB_BENCH_OBJECTS; i++){
+		if(objects[i] == NULL) result = FAIL;
+		else frame_free((uint32_t)objects[i], 0);
+	}
+	frame_cycles = rdtsc() - start;
+
+	/* after: slab objects */
+	start = rdtsc();
+	for(i = 0; i < SLAB_BENCH_OBJECTS; i++) objects[i] = (uint8_t*)kmalloc(SLAB_BENCH_SIZE);
+	alloc_cycles = rdtsc() - start;
+	for(i = 0; i < SLAB_BENCH_OBJECTS; i++){
+		if(objects[i] == NULL || ((uint32_t)objects[i] & (SLAB_ALIGN - 1)) != 0) result = FAIL;
+		if(objects[i] != NULL) memset(objects[i], (uint8_t)i, SLAB_BENCH_SIZE);
+	}
+	for(i = 0; i < SLAB_BENCH_OBJECTS; i++){
+		for(j = 0; objects[i] != NULL && j < SLAB_BENCH_SIZE; j++){
+			if(objects[i][j] != (uint8_t)i) result = FAIL;
+		}
+	}
+	start = rdtsc();
+	for(i = 0; i < SLAB_BENCH_OBJECTS; i++) kfree(objects[i]);
+	free_cycles = rdtsc() - start;
+
+	printf("frame alloc+free %u cycles, kmalloc %u cycles, kfree %u cycles\n",
+		frame_cycles / SLAB_BENCH_OBJECTS, alloc_cycles / SLAB_BENCH_OBJECTS, free_cycles / SLAB_BENCH_OBJECTS);
+	return result;
+}
+
+/* frame_alloc_test
+*
+* Allocates blocks of every order, checks that they are aligned to their
+* size and don't overlap, then frees them and checks the free count goes
+* back to where it started, which only happens if buddies merged again
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: NONE
+* Coverage: frame_alloc, frame_free
+* Files: frame_alloc.c
+*/
+int frame_alloc_test(){
+	TEST_HEADER;
+	int result = PASS;
+	uint32_t blocks[FRAME_MAX_ORDER + 1];
+	uint32_t order, other, before = frame_free_count();
+	for(order = 0; order <= FRAME_MAX_ORDER; order++){
+		blocks[order] = frame_alloc(order);
+		if(blocks[order] == 0 || (blocks[order] & ((FRAME_SIZE << order) - 1)) != 0) result = FAIL;
+		for(other = 0; other < order; other++){
+			if(blocks[other] < blocks[order] + (FRAME_SIZE << order) && blocks[order] < blocks[other] + (FRAME_SIZE << other)) result = FAIL;
+		}
+	}
+	if(frame_free_count() != before - ((1 << (FRAME_MAX_ORDER + 1)) - 1)) result = FAIL;
+	for(order = 0; order <= FRAME_MAX_ORDER; order++){
+		frame_free(blocks[order], order);
+	}
+	if(frame_free_count() != before) result = FAIL;
+
+	/* two halves of a split block merge back into one */
+	uint32_t big = frame_alloc(FRAME_MAX_ORDER);
+	frame_free(big, FRAME_MAX_ORDER);
+	blocks[0] = frame_alloc(FRAME_MAX_ORDER - 1);
+	blocks[1] = frame_alloc(FRAME_MAX_ORDER - 1);
+	frame_free(blocks[0], FRAME_MAX_ORDER - 1);
+	frame_free(blocks[1], FRAME_MAX_ORDER - 1);
+	if(frame_alloc(FRAME_MAX_ORDER) != big) result = FAIL;
+	frame_free(big, FRAME_MAX_ORDER);
+
+	printf("%u of %u frames free\n", frame_free_count(), frame_total_count());
+	return result;
+}
+
+/* text_share_test
+*
+* Runs the same program as process 0 and process 1. Process 0 faults every
+* page of the image in, then process 1 should find all of them mapped
+* straight from the page cache. A write from process 1 must give it its own
+* copy of the page without changing what process 0 sees
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Borrows the memory of processes 0 and 1, prints cycles
+* Coverage: share_program_text, demand_page, page cache
+* Files: paging.c, page_cache.c
+*/
+int text_share_test(){
+	TEST_HEADER;
+	uint32_t first_idx = (PROG_CODE_START - VIRT_PAGE_START) >> TABLE_INDEX_SHIFT;
+	uint32_t i, pages, start, first, second, shared = 0;
+	volatile uint8_t touch;
+	dentry_t dentry;
+	if(read_dentry_by_name((uint8_t*)"shell", &dentry) != 0) return FAIL;
+	pcb_t* one = pcb_init((uint8_t*)"shell", 0x0, 0);
+	pcb_t* two = pcb_init((uint8_t*)"shell", 0x0, 1);
+	one->exe_inode = two->exe_inode = dentry.inode_num;
+	one->exe_length = two->exe_length = file_length(dentry.inode_num);
+	pages = (one->exe_length + FOUR_KB - 1) / FOUR_KB;
+
+	/* first instance loads every page of the image */
+	start = rdtsc();
+	reset_process_pages(0);
+	map_process_pages(0);
+	set_pcb(one);
+	for(i = 0; i < pages; i++) touch = *(uint8_t*)(PROG_CODE_START + i * FOUR_KB);
+	first = rdtsc() - start;
+
+	/* second instance gets them mapped at setup time */
+	start = rdtsc();
+	reset_process_pages(1);
+	share_program_text(1, two->exe_inode, two->exe_length);
+	map_process_pages(1);
+	set_pcb(two);
+	for(i = 0; i < pages; i++) touch = *(uint8_t*)(PROG_CODE_START + i * FOUR_KB);
+	second = rdtsc() - start;
+
+	for(i = 0; i < pages; i++){
+		if(get_program_table(0)[first_idx + i] == get_program_table(1)[first_idx + i]) shared++;
+	}
+	printf("%u/%u pages shared, first exec %u cycles, second %u cycles\n", shared, pages, first, second);
+
+	/* writing the last page of the image copies it for process 1 only */
+	uint8_t* last = (uint8_t*)(PROG_CODE_START + (pages - 1) * FOUR_KB);
+	touch = *last;
+	*last = touch + 1;
+	int result = (shared == pages) && !(get_program_table(1)[first_idx + pages - 1] & FLAG_COW);
+	map_process_pages(0);
+	set_pcb(one);
+	if(*last != touch) result = FAIL;
+
+	reset_process_pages(0);
+	reset_process_pages(1);
+	set_pcb(NULL);
+	return result ? PASS : FAIL;
+}
+
+/* run_queue_test
+*
+* Puts two processes on the run queue, checks the circular order, then
+* blocks one on a wait queue and makes sure only waking that queue brings
+* it back
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Borrows pcbs 4 and 5, must run before the scheduler starts
+* Coverage: run_queue_add, run_queue_remove, wait_queue_wake_all
+* Files: scheduler.c, wait_queue.c
+*/
+int run_queue_test(){
+	TEST_HEADER;
+	int result = PASS;
+	wait_queue_t queue, other;
+	wait_queue_init(&queue);
+	wait_queue_init(&other);
+	set_pcb(NULL);
+	pcb_t* a = pcb_init((uint8_t*)"a", 0x0, 4);
+	pcb_t* b = pcb_init((uint8_t*)"b", 0x0, 5);
+	run_queue_add(a);
+	run_queue_add(b);
+	if(a->run_next != b || b->run_next != a || a->run_prev != b) result = FAIL;
+
+	/* a blocks, b is alone on the run queue */
+	a->state = PROCESS_BLOCKED;
+	queue.first = queue.last = a;
+	run_queue_remove(a);
+	if(b->run_next != b || a->run_next != NULL) result = FAIL;
+	wait_queue_wake_all(&other);
+	if(a->state != PROCESS_BLOCKED) result = FAIL;
+	wait_queue_wake_all(&queue);
+	if(a->state != PROCESS_RUNNABLE || b->run_next != a || a->run_next != b || queue.first != NULL) result = FAIL;
+
+	run_queue_remove(a);
+	run_queue_remove(b);
+	return result;
+}
+
+/* spins with interrupts on, like the old terminal_read loop */
+static void cpu_test_spinner(){
+	sti();
+	while(1){}
+}
+
+/* counts loop iterations until CPU_TEST_TICKS more PIT ticks have passed */
+static uint32_t cpu_test_work(){
+	volatile uint32_t count = 0;
+	uint32_t end = pit_ticks + CPU_TEST_TICKS;
+	while(pit_ticks < end) count++;
+	return count;
+}
+
+/* idle_terminal_cpu_test
+*
+* Measures how much CPU a compute-bound process (the test itself, as
+* process 3) gets while the other two terminals sit at their prompts. First
+* the two prompt processes are blocked on their terminals' wait queues, then
+* they are put on the run queue spinning, the way terminal_read used to wait
+* Inputs: None
+* Outputs: PASS/FAIL
+* Side Effects: Borrows pcbs 3 to 5 and starts the PIT, must run before the
+*               scheduler starts
+* Coverage: wait_event, schedule, switch_context
+* Files: scheduler.c, wait_queue.c, terminal.c
+*/
+int idle_terminal_cpu_test(){
+	TEST_HEADER;
+	uint32_t blocked, spinning, i;
+	set_pcb(NULL);
+	pcb_t* work = pcb_init((uint8_t*)"work", 0x0, 3);
+	pcb_t* prompts[2];
+	prompts[0] = pcb_init((uint8_t*)"shell", 0x0, 4);
+	prompts[1] = pcb_init((uint8_t*)"shell", 0x0, 5);
+	terminal_process_nums[0] = 3;
+	terminal_process_nums[1] = 4;
+	terminal_process_nums[2] = 5;
+
+	/* prompts asleep until enter is pressed on terminals 1 and 2 */
+	cli();
+	for(i = 0; i < 2; i++){
+		prompts[i]->terminal = i + 1;
+		enter_queue[i + 1].first = enter_queue[i + 1].last = prompts[i];
+	}
+	work->state = PROCESS_RUNNABLE;
+	run_queue_add(work);
+	set_pcb(work);
+	pit_init();
+	sti();
+	blocked = cpu_test_work();
+
+	/* prompts spinning, each gets its share of the ticks */
+	cli();
+	for(i = 0; i < 2; i++){
+		wait_queue_init(&enter_queue[i + 1]);
+		prompts[i]->context_esp = scheduler_new_context(pcb_stack_top(prompts[i]), cpu_test_spinner);
+		prompts[i]->state = PROCESS_RUNNABLE;
+		run_queue_add(prompts[i]);
+	}
+	sti();
+	spinning = cpu_test_work();
+
+	cli();
+	disable_irq(0);
+	for(i = 0; i < 2; i++) run_queue_remove(prompts[i]);
+	run_queue_remove(work);
+	for(i = 0; i < MAX_TERMINALS; i++) terminal_process_nums[i] = NOT_ASSIGNED;
+	set_pcb(NULL);
+	sti();
+
+	printf("work done in %d ticks: %u with prompts blocked, %u with prompts spinning\n", CPU_TEST_TICKS, blocked, spinning);
+	return (blocked > 2 * spinning) ? PASS : FAIL;
+}
+
+/* kernel contexts bounced between by context_switch_bench */
+static uint32_t pingpong_main_esp, pingpong_partner_esp;
+static void (*pingpong_switch_mm)(uint32_t process_id);
+
+/* how switches worked before: one directory, rewritten and fully flushed */
+static void shared_directory_switch(uint32_t process_id){
+	*get_page_directory(PROG_PAGE_IDX) = (uint32_t)get_program_table(process_id) | FLAG_P | FLAG_RW | FLAG_US;
+	*get_page_directory(MMAP_DIR_IDX) = (uint32_t)get_mmap_table(process_id) | FLAG_P | FLAG_RW | FLAG_US;
+	map_kernel_pages();
+}
+
+/* touches what a process switch usually touches next: its own stack,
+ * the kernel and the screen */
+static uint8_t pingpong_touch(){
+	return *(volatile uint8_t*)(VIRT_PAGE_START + PROGRAM_SIZE - LONG)
+	     + *(volatile uint8_t*)VIDEO_MEMORY
+	     + *(volatile uint8_t*)&pingpong_main_esp;
+}
+
+/* process 1 of the ping-pong, hands straight back to process 0 */
+static void pingpong_partner(){
+	while(1){
+		pingpong_switch_mm(0);
+		pingpong_touch();
+		switch_context(&pingpong_partner_esp, pingpong_main_esp);
+	}
+}
+
+/* sets the CR4 global page bit */
+static void set_global_pages(int enable){
+	uint32_t cr4;
+	asm volatile ("movl %%cr4, %0" : "=r"(cr4));
+	cr4 = enable ? (cr4 | CR4_PGE) : (cr4 & ~CR4_PGE);
+	asm volatile ("movl %0, %%cr4" : : "r"(cr4) : "memory");
+}
+
+/* runs PINGPONG_ROUNDS round trips, returns cycles per switch */
+static uint32_t pingpong_run(void (*switch_mm)(uint32_t process_id)){
+	uint32_t i, start;
+	pingpong_switch_mm = switch_mm;
+	pingpong_partner_esp = scheduler_new_context(pcb_stack_top(get_pcb(1)), pingpong_partner);
+	start = rdtsc();
+	for(i = 0; i < PINGPONG_ROUNDS; i++){
+		switch_mm(1);
+		pingpong_touch();
+		switch_context(&pingpong_main_esp, pingpong_partner_esp);
+	}
+	return (rdtsc() - start) / (2 * PINGPONG_ROUNDS);
+}
+
+/* context_switch_bench
+*
+* Two kernel contexts standing in for processes 0 and 1 switch back and
+* forth, each touching its user stack, video memory and kernel data after
+* the switch. Before: a single directory whose program entries are
+* rewritten with global pages off. After: per-process directories with
+* global kernel and video pages
+* Inputs: None
+* Outputs: PASS
+* Side Effects: Borrows the stacks and tables of processes 0 and 1
+* Coverage: map_process_pages, switch_context
+* Files: paging.c, scheduler_asm.S
+*/
+int context_switch_bench(){
+	TEST_HEADER;
+	uint32_t before, after, flags;
+	set_pcb(NULL);
+	if(pcb_init((uint8_t*)"ping", 0x0, 0) == NULL || pcb_init((uint8_t*)"pong", 0x0, 1) == NULL) return FAIL;
+	cli_and_save(flags);
+	reset_process_pages(0);
+	reset_process_pages(1);
+	get_program_table(0)[NUM_OF_ENTRIES - 1] = frame_alloc(0) | FLAG_P | FLAG_RW | FLAG_US;
+	get_program_table(1)[NUM_OF_ENTRIES - 1] = frame_alloc(0) | FLAG_P | FLAG_RW | FLAG_US;
+
+	set_global_pages(0);
+	before = pingpong_run(shared_directory_switch);
+	*get_page_directory(PROG_PAGE_IDX) = FLAG_RW;
+	*get_page_directory(MMAP_DIR_IDX) = FLAG_RW;
+	set_global_pages(1);
+	after = pingpong_run(map_process_pages);
+
+	reset_process_pages(0);
+	reset_process_pages(1);
+	map_kernel_pages();
+	restore_flags(flags);
+	printf("switch: shared directory %u cycles, per-process directory %u cycles\n", before, after);
+	return PASS;
+}
+
 /* Checkpoint 3 tests */
  void s_test() {
     const char * cmd = "counter";
@@ -560,6 +2299,57 @@ int read_from_large_file(){
 /* Checkpoint 5 tests */
 
 
+/* tests that can be picked with tests= on the boot command line, the ones
+ * that throw exceptions or wait for the keyboard are left out */
+static const struct {
+	const int8_t* name;
+	int (*test)();
+} boot_tests[] = {
+	{"idt_test", idt_test},
+	{"valid_paging_test", valid_paging_test},
+	{"keyboard_ID_test", keyboard_ID_test},
+	{"power_2_test", power_2_test},
+	{"ls_test", ls_test},
+	{"file_read_test", file_read_test},
+	{"file_read_offset_test", file_read_offset_test},
+	{"read_from_non_txt_test", read_from_non_txt_test},
+	{"read_from_large_file", read_from_large_file},
+	{"dentry_lookup_bench", dentry_lookup_bench},
+	{"read_data_chunk_test", read_data_chunk_test},
+	{"mmap_read_bench", mmap_read_bench},
+	{"exec_load_bench", exec_load_bench},
+	{"text_share_test", text_share_test},
+	{"run_queue_test", run_queue_test},
+	{"idle_terminal_cpu_test", idle_terminal_cpu_test},
+	{"context_switch_bench", context_switch_bench},
+	{"frame_alloc_test", frame_alloc_test},
+	{"process_table_stress_test", process_table_stress_test},
+	{"kmalloc_bench", kmalloc_bench},
+	{"fork_bench", fork_bench},
+	{"background_jobs_test", background_jobs_test},
+	{"pipe_throughput_bench", pipe_throughput_bench},
+	{"signal_delivery_test", signal_delivery_test},
+	{"signal_fault_test", signal_fault_test},
+	{"signal_wake_test", signal_wake_test},
+	{"timer_accuracy_bench", timer_accuracy_bench},
+	{"rtc_virtual_test", rtc_virtual_test},
+	{"quantum_bench", quantum_bench},
+	{"profile_test", profile_test},
+	{"console_write_bench", console_write_bench},
+	{"console_scroll_bench", console_scroll_bench},
+	{"console_bulk_bench", console_bulk_bench},
+	{"console_switch_bench", console_switch_bench},
+	{"console_scrollback_test", console_scrollback_test},
+};
+
+/* Runs the tests tests= names, so a benchmark can be picked per boot */
+void launch_boot_tests(){
+	uint32_t i;
+	for(i = 0; i < sizeof(boot_tests) / sizeof(boot_tests[0]); i++){
+		if(config_selects(boot_tests[i].name)) TEST_OUTPUT(boot_tests[i].name, boot_tests[i].test());
+	}
+}
+
 /* Test suite entry point */
 void launch_tests(){
 	//TEST_OUTPUT("idt_test", idt_test());
@@ -590,6 +2380,32 @@ void launch_tests(){
     //TEST_OUTPUT("file_read_offset_test", file_read_offset_test());
     //TEST_OUTPUT("read_from_non_txt_test", read_from_non_txt_test());
     //TEST_OUTPUT("read_from_large_file", read_from_large_file());
+    //TEST_OUTPUT("dentry_lookup_bench", dentry_lookup_bench());
+    //TEST_OUTPUT("read_data_chunk_test", read_data_chunk_test());
+    //TEST_OUTPUT("mmap_read_bench", mmap_read_bench());
+    //TEST_OUTPUT("exec_load_bench", exec_load_bench());
+    //TEST_OUTPUT("text_share_test", text_share_test());
+    //TEST_OUTPUT("run_queue_test", run_queue_test());
+    //TEST_OUTPUT("idle_terminal_cpu_test", idle_terminal_cpu_test());
+    //TEST_OUTPUT("context_switch_bench", context_switch_bench());
+    //TEST_OUTPUT("frame_alloc_test", frame_alloc_test());
+    //TEST_OUTPUT("process_table_stress_test", process_table_stress_test());
+    //TEST_OUTPUT("kmalloc_bench", kmalloc_bench());
+    //TEST_OUTPUT("fork_bench", fork_bench());
+    //TEST_OUTPUT("background_jobs_test", background_jobs_test());
+    //TEST_OUTPUT("pipe_throughput_bench", pipe_throughput_bench());
+    //TEST_OUTPUT("signal_delivery_test", signal_delivery_test());
+    //TEST_OUTPUT("signal_fault_test", signal_fault_test());
+    //TEST_OUTPUT("signal_wake_test", signal_wake_test());
+    //TEST_OUTPUT("timer_accuracy_bench", timer_accuracy_bench());
+    //TEST_OUTPUT("rtc_virtual_test", rtc_virtual_test());
+    //TEST_OUTPUT("quantum_bench", quantum_bench());
+    //TEST_OUTPUT("profile_test", profile_test());
+    //TEST_OUTPUT("console_write_bench", console_write_bench());
+    //TEST_OUTPUT("console_scroll_bench", console_scroll_bench());
+    //TEST_OUTPUT("console_bulk_bench", console_bulk_bench());
+    //TEST_OUTPUT("console_switch_bench", console_switch_bench());
+    //TEST_OUTPUT("console_scrollback_test", console_scrollback_test());
     return;
 }
 
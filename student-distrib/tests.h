@@ -4,4 +4,7 @@
 // test launcher
 void launch_tests();
 
+// runs the tests named by tests= on the boot command line
+void launch_boot_tests();
+
 #endif /* TESTS_H */
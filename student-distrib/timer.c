@@ -0,0 +1,166 @@
+#include "timer.h"
+#include "lib.h"
+#include "pit.h"
+
+// One list per slot. A timer goes in the slot of the tick it expires on,
+// so a tick only looks at one slot however many timers are pending
+static ktimer_t* timer_wheel[TIMER_WHEEL_SLOTS];
+
+static void timer_link(ktimer_t* timer, uint32_t expires);
+
+/* timer_init
+ * DESCRIPTION: Empties every slot of the wheel
+ * INPUTS: NONE
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void timer_init() {
+    uint32_t i;
+    for (i = 0; i < TIMER_WHEEL_SLOTS; i++) { timer_wheel[i] = NULL; }
+}
+
+/* timer_setup
+ * DESCRIPTION: Sets up a timer that isn't on the wheel
+ * INPUTS: timer - timer to set up
+ *         function - run from the PIT interrupt when the timer fires
+ *         data - passed to function
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void timer_setup(ktimer_t* timer, void (*function)(void* data), void* data) {
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->pending = 0;
+    timer->function = function;
+    timer->data = data;
+}
+
+/* timer_add
+ * DESCRIPTION: Links a timer into the slot of the tick it expires on
+ * INPUTS: timer - timer that isn't pending
+ *         ticks - PIT ticks from now, at least 1
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void timer_add(ktimer_t* timer, uint32_t ticks) {
+    uint32_t flags;
+    if (ticks == 0) { ticks = 1; }
+
+    cli_and_save(flags);
+    timer_link(timer, pit_ticks + ticks);
+    restore_flags(flags);
+}
+
+/* timer_del
+ * DESCRIPTION: Unlinks a timer from its slot if it hasn't fired yet
+ * INPUTS: timer - timer to cancel
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void timer_del(ktimer_t* timer) {
+    uint32_t flags;
+    cli_and_save(flags);
+    if (timer->pending) {
+        if (timer->prev != NULL) { timer->prev->next = timer->next; }
+        else { timer_wheel[timer->expires & TIMER_WHEEL_MASK] = timer->next; }
+        if (timer->next != NULL) { timer->next->prev = timer->prev; }
+        timer->next = NULL;
+        timer->prev = NULL;
+        timer->pending = 0;
+    }
+    restore_flags(flags);
+}
+
+/* timer_tick
+ * DESCRIPTION: Fires every timer in the slot of now that expires on it.
+ *              Timers a whole turn of the wheel or more away share the slot
+ *              and stay
+ * INPUTS: now - the tick that just happened
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Runs timer functions with interrupts off
+ */
+void timer_tick(uint32_t now) {
+    uint32_t flags;
+    ktimer_t* timer;
+    ktimer_t* next;
+
+    cli_and_save(flags);
+    for (timer = timer_wheel[now & TIMER_WHEEL_MASK]; timer != NULL; timer = next) {
+        next = timer->next;
+        if (timer->expires != now) { continue; }
+        timer_del(timer);
+        timer->function(timer->data);
+    }
+    restore_flags(flags);
+}
+
+/* timer_next
+ * DESCRIPTION: Looks ahead slot by slot for the first timer to fire, so
+ *              the idle loop knows how long it can go without ticks. Only
+ *              called while idle, so walking the slots is fine
+ * INPUTS: now - current tick
+ *         limit - most ticks to look ahead
+ * OUTPUTS: ticks until the first timer, limit if none comes sooner
+ * SIDE EFFECTS: NONE
+ */
+uint32_t timer_next(uint32_t now, uint32_t limit) {
+    uint32_t ticks;
+    ktimer_t* timer;
+    if (limit > TIMER_WHEEL_SLOTS) { limit = TIMER_WHEEL_SLOTS; }
+
+    for (ticks = 1; ticks < limit; ticks++) {
+        for (timer = timer_wheel[(now + ticks) & TIMER_WHEEL_MASK]; timer != NULL; timer = timer->next) {
+            if (timer->expires == now + ticks) { return ticks; }
+        }
+    }
+    return limit;
+}
+
+/* timer_rescale
+ * DESCRIPTION: Moves every pending timer when the tick rate changes, so it
+ *              still fires after the same time, rounded up to a tick
+ * INPUTS: now - current tick
+ *         old_hz - rate the timers were added at
+ *         new_hz - rate from now on
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void timer_rescale(uint32_t now, uint32_t old_hz, uint32_t new_hz) {
+    uint32_t flags, i, left;
+    ktimer_t* timer;
+    ktimer_t* all = NULL;
+
+    cli_and_save(flags);
+    for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        while ((timer = timer_wheel[i]) != NULL) {
+            timer_wheel[i] = timer->next;
+            timer->next = all;
+            all = timer;
+        }
+    }
+    while ((timer = all) != NULL) {
+        all = timer->next;
+        left = timer->expires - now;
+        left = left / old_hz * new_hz + ((left % old_hz) * new_hz + old_hz - 1) / old_hz;
+        timer_link(timer, now + ((left == 0) ? 1 : left));
+    }
+    restore_flags(flags);
+}
+
+/* timer_link
+ * DESCRIPTION: Puts a timer at the front of the slot it expires in.
+ *              Called with interrupts disabled
+ * INPUTS: timer - timer that isn't on the wheel
+ *         expires - tick it fires on
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+static void timer_link(ktimer_t* timer, uint32_t expires) {
+    ktimer_t** slot = &timer_wheel[expires & TIMER_WHEEL_MASK];
+    timer->expires = expires;
+    timer->prev = NULL;
+    timer->next = *slot;
+    if (timer->next != NULL) { timer->next->prev = timer; }
+    *slot = timer;
+    timer->pending = 1;
+}
@@ -0,0 +1,47 @@
+#ifndef _TIMER_H
+#define _TIMER_H
+
+#include "types.h"
+
+#define TIMER_WHEEL_SLOTS   256     // power of two, 6.4 seconds of 40 Hz ticks
+#define TIMER_WHEEL_MASK    (TIMER_WHEEL_SLOTS - 1)
+#define MS_PER_SECOND       1000
+
+/* testing constants */
+#define TIMER_BENCH_ROUNDS  20
+#define TIMER_BENCH_MS      100
+#define TIMER_BENCH_PENDING 4096
+
+// A callback run from the PIT interrupt once its tick comes. Lives in the
+// structure that owns it, the wheel only links it in
+typedef struct ktimer {
+    struct ktimer* next;        // neighbours in the same wheel slot
+    struct ktimer* prev;
+    uint32_t expires;           // pit tick it fires on
+    uint8_t pending;            // on the wheel and not fired yet
+    void (*function)(void* data);
+    void* data;
+} ktimer_t;
+
+// Empties every slot of the wheel
+extern void timer_init();
+
+// Sets up a timer that isn't on the wheel
+extern void timer_setup(ktimer_t* timer, void (*function)(void* data), void* data);
+
+// Puts a timer on the wheel to fire ticks PIT ticks from now
+extern void timer_add(ktimer_t* timer, uint32_t ticks);
+
+// Takes a timer off the wheel if it hasn't fired
+extern void timer_del(ktimer_t* timer);
+
+// Fires the timers due at a tick, called from the PIT interrupt
+extern void timer_tick(uint32_t now);
+
+// Ticks from now until the first timer fires, at most limit
+extern uint32_t timer_next(uint32_t now, uint32_t limit);
+
+// Moves every pending timer for a new tick rate
+extern void timer_rescale(uint32_t now, uint32_t old_hz, uint32_t new_hz);
+
+#endif
@@ -0,0 +1,112 @@
+#include "wait_queue.h"
+#include "lib.h"
+#include "pcb.h"
+#include "scheduler.h"
+#include "signal.h"
+
+/* wait_queue_init
+ * DESCRIPTION: Empties a wait queue
+ * INPUTS: queue - queue to set up
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void wait_queue_init(wait_queue_t* queue) {
+    queue->first = NULL;
+    queue->last = NULL;
+}
+
+/* wait_queue_sleep
+ * DESCRIPTION: Takes the current process off the run queue, appends it to
+ *              the wait queue and runs something else until it is woken.
+ *              Before any process exists it just waits for the next
+ *              interrupt. Use wait_event rather than calling this directly
+ * INPUTS: queue - queue to sleep on
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: Switches processes
+ */
+void wait_queue_sleep(wait_queue_t* queue) {
+    pcb_t* pcb = find_pcb();
+    if (pcb == NULL) {
+        asm volatile ("sti; hlt; cli");
+        return;
+    }
+
+    pcb->wait_next = NULL;
+    pcb->wait_queue = queue;
+    if (queue->last == NULL) { queue->first = pcb; }
+    else { queue->last->wait_next = pcb; }
+    queue->last = pcb;
+
+    pcb->state = PROCESS_BLOCKED;
+    run_queue_remove(pcb);
+    schedule();
+}
+
+/* wait_queue_wake_all
+ * DESCRIPTION: Puts every process on the wait queue back on the run queue.
+ *              Safe to call from interrupt handlers
+ * INPUTS: queue - queue to empty
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void wait_queue_wake_all(wait_queue_t* queue) {
+    uint32_t flags;
+    cli_and_save(flags);
+    pcb_t* pcb = queue->first;
+    queue->first = NULL;
+    queue->last = NULL;
+    while (pcb != NULL) {
+        pcb_t* next = pcb->wait_next;
+        pcb->wait_next = NULL;
+        pcb->wait_queue = NULL;
+        pcb->state = PROCESS_RUNNABLE;
+        run_queue_add(pcb);
+        pcb = next;
+    }
+    restore_flags(flags);
+}
+
+/* wait_queue_wake
+ * DESCRIPTION: Takes a process off the wait queue it sleeps on and puts it
+ *              back on the run queue, the rest of the queue keeps sleeping.
+ *              Nothing happens if it isn't on a wait queue
+ * INPUTS: pcb - process to wake
+ * OUTPUTS: NONE
+ * SIDE EFFECTS: NONE
+ */
+void wait_queue_wake(pcb_t* pcb) {
+    uint32_t flags;
+    cli_and_save(flags);
+    wait_queue_t* queue = pcb->wait_queue;
+    if (queue == NULL) {
+        restore_flags(flags);
+        return;
+    }
+
+    pcb_t** link = &(queue->first);
+    pcb_t* prev = NULL;
+    while (*link != pcb) {
+        prev = *link;
+        link = &((*link)->wait_next);
+    }
+    *link = pcb->wait_next;
+    if (queue->last == pcb) { queue->last = prev; }
+
+    pcb->wait_next = NULL;
+    pcb->wait_queue = NULL;
+    pcb->state = PROCESS_RUNNABLE;
+    run_queue_add(pcb);
+    restore_flags(flags);
+}
+
+/* wait_queue_interrupted
+ * DESCRIPTION: Checks whether the current process has a signal pending
+ *              that it has to take now, so wait_event stops sleeping
+ * INPUTS: NONE
+ * OUTPUTS: nonzero if it does, 0 otherwise or before any process exists
+ * SIDE EFFECTS: NONE
+ */
+int32_t wait_queue_interrupted() {
+    pcb_t* pcb = find_pcb();
+    return pcb != NULL && signal_interrupts(pcb);
+}
@@ -0,0 +1,45 @@
+#ifndef _WAIT_QUEUE_H
+#define _WAIT_QUEUE_H
+
+#include "types.h"
+
+struct pcb_t;
+
+// Processes blocked until some event, in the order they went to sleep. The
+// links live in the pcbs, a zeroed queue is empty
+typedef struct wait_queue {
+    struct pcb_t* first;
+    struct pcb_t* last;
+} wait_queue_t;
+
+// Sleeps on queue until condition holds, or until the process has a
+// signal to take. Interrupts are off while the condition is checked, so a
+// wakeup can't slip in before the sleep. Callers check the condition again
+// and return FAILURE when it still doesn't hold, so the signal is delivered
+// on the way back to user space
+#define wait_event(queue, condition)                            \
+do {                                                            \
+    uint32_t wait_flags;                                        \
+    cli_and_save(wait_flags);                                   \
+    while (!(condition) && !wait_queue_interrupted()) {         \
+        wait_queue_sleep(queue);                                \
+    }                                                           \
+    restore_flags(wait_flags);                                  \
+} while (0)
+
+// Empties a queue
+extern void wait_queue_init(wait_queue_t* queue);
+
+// Blocks the current process on the queue, interrupts must be off
+extern void wait_queue_sleep(wait_queue_t* queue);
+
+// Makes every process on the queue runnable again
+extern void wait_queue_wake_all(wait_queue_t* queue);
+
+// Takes one process off the queue it sleeps on and makes it runnable
+extern void wait_queue_wake(struct pcb_t* pcb);
+
+// Nonzero when the current process has a signal that cuts a sleep short
+extern int32_t wait_queue_interrupted();
+
+#endif